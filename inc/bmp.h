@@ -19,7 +19,21 @@
  * 192-262/312 = blank<br>
  * <br>
  * With extended blank bitmap can be transfered to VRAM 20 times per second in NTSC<br>
- * and 25 time per second in PAL.
+ * and 25 time per second in PAL.<br>
+ * <br>
+ * In tile order mode (see BMP_initEx(..)) the buffer is stored in VRAM tile order so it is transfered
+ * with DMA instead of CPU writes, the whole buffer is sent in 2 frames in NTSC and 1 frame in PAL.<br>
+ * <br>
+ * In dirty rows mode (see BMP_initEx(..)) only the tile rows which changed since the last transfer
+ * of the target VRAM buffer are sent, mostly static scenes can then flip several times faster.<br>
+ * <br>
+ * Bitmap resolution can be reduced with BMP_initEx(..) (letterbox or 128 pixels wide mode), the extended
+ * blank period grows accordingly so a smaller bitmap is transfered faster.<br>
+ * BMP_WIDTH and BMP_HEIGHT are the maximum resolution, use BMP_getWidth() and BMP_getHeight()
+ * to get the current one.<br>
+ * <br>
+ * By default pixels are rendered with X doubled resolution (a byte = 2 identical pixels), in 4bpp mode
+ * (see BMP_initEx(..)) pixel, line and polygon methods use the real X resolution (a byte = 2 pixels).
  */
 
 #include "maths.h"
@@ -51,12 +65,12 @@
 #define BMP_CELLWIDTH_SFT           5
 /**
  *  \brief
- *          Bitmap width (in tile) : 32
+ *          Maximum bitmap width (in tile) : 32
  */
 #define BMP_CELLWIDTH               (1 << BMP_CELLWIDTH_SFT)
 /**
  *  \brief
- *          Bitmap height (in tile) : 20
+ *          Maximum bitmap height (in tile) : 20
  */
 #define BMP_CELLHEIGHT              20
 #define BMP_CELLWIDTHMASK           (BMP_CELLWIDTH - 1)
@@ -82,12 +96,12 @@
 #define BMP_WIDTH_SFT               (BMP_CELLWIDTH_SFT + BMP_XPIXPERTILE_SFT)
 /**
  *  \brief
- *          Bitmap width (in pixel) : 256
+ *          Maximum bitmap width (in pixel) : 256
  */
 #define BMP_WIDTH                   (1 << BMP_WIDTH_SFT)
 /**
  *  \brief
- *          Bitmap height (in pixel) : 160
+ *          Maximum bitmap height (in pixel) : 160
  */
 #define BMP_HEIGHT                  (BMP_CELLHEIGHT * BMP_YPIXPERTILE)
 #define BMP_WIDTH_MASK              (BMP_WIDTH - 1)
@@ -100,6 +114,39 @@
 #define BMP_PITCH                   (1 << BMP_PITCH_SFT)
 #define BMP_PITCH_MASK              (BMP_PITCH - 1)
 
+/**
+ *  \brief
+ *          Enable VRAM double buffer (see BMP_initEx(..)).
+ */
+#define BMP_FLAG_DOUBLEBUFFER       (1 << 0)
+/**
+ *  \brief
+ *          Store bitmap buffer in VRAM tile order (see BMP_initEx(..)).
+ */
+#define BMP_FLAG_TILEORDER          (1 << 1)
+/**
+ *  \brief
+ *          Only transfer modified tile rows on flip (see BMP_initEx(..)).
+ */
+#define BMP_FLAG_DIRTYROWS          (1 << 2)
+/**
+ *  \brief
+ *          Real X resolution drawing (2 pixels per byte, see BMP_initEx(..)).
+ */
+#define BMP_FLAG_4BPP               (1 << 3)
+
+/**
+ *  \brief
+ *          Get buffer offset of the specified byte (2 pixels) in tile order mode.
+ *      \param xb
+ *          X byte coordinate (X pixel / 2).
+ *      \param y
+ *          Y coordinate.
+ *
+ * A 8x8 tile is 32 consecutive bytes (4 bytes per line) and tiles are stored row by row.
+ */
+#define BMP_TILEOFFSET(xb, y)       (((((y) >> BMP_YPIXPERTILE_SFT) << BMP_CELLWIDTH_SFT) << 5) + (((xb) >> 2) << 5) + (((y) & BMP_YPIXPERTILEMASK) << 2) + ((xb) & 3))
+
 /**
  *  \brief
  *          Get width of genesis bitmap 16 object.
@@ -131,9 +178,15 @@
  *
  * Pixels are rendereded with X doubled resolution (byte operation) for performance reason.<br>
  * So BMP_GETPIXEL(0,0) will actually returns same value as BMP_GETPIXEL((1,0)<br>
- * Be careful this function does not check for retrieving pixel outside bitmap buffer.
+ * Be careful this function does not check for retrieving pixel outside bitmap buffer.<br>
+ * Works only in linear mode, use BMP_GETPIXEL_TILE(..) in tile order mode.
  */
 #define BMP_GETPIXEL(x, y)          bmp_buffer_write[((y) * BMP_PITCH) + ((x) >> 1)]
+/**
+ *  \brief
+ *          Same as BMP_GETPIXEL(..) for tile order mode.
+ */
+#define BMP_GETPIXEL_TILE(x, y)     bmp_buffer_write[BMP_TILEOFFSET((x) >> 1, y)]
 
 /**
  *  \brief
@@ -148,9 +201,47 @@
  *
  * Pixels are rendereded with X doubled resolution (byte operation) for performance reason.<br>
  * So BMP_SETPIXEL(0,0,..) will actually set same pixel as BMP_SETPIXEL(1,0,..).
- * Be careful this function does not check for retrieving pixel outside bitmap buffer.
+ * Be careful this function does not check for retrieving pixel outside bitmap buffer.<br>
+ * Works only in linear mode, use BMP_SETPIXEL_TILE(..) in tile order mode.
  */
 #define BMP_SETPIXEL(x, y, col)     bmp_buffer_write[((y) * BMP_PITCH) + ((x) >> 1)] = col;
+/**
+ *  \brief
+ *          Same as BMP_SETPIXEL(..) for tile order mode.
+ */
+#define BMP_SETPIXEL_TILE(x, y, col)    bmp_buffer_write[BMP_TILEOFFSET((x) >> 1, y)] = col;
+
+/**
+ *  \brief
+ *          Set a 4bpp pixel in the byte at specified address.
+ *      \param p
+ *          Byte address.
+ *      \param x
+ *          X pixel coordinate (even = high nibble = left pixel).
+ *      \param col
+ *          pixel color (0-15).
+ */
+#define BMP_SETNIBBLE(p, x, col)        { u8 *_p = (p); if ((x) & 1) *_p = (*_p & 0xF0) | (col); else *_p = (*_p & 0x0F) | ((col) << 4); }
+/**
+ *  \brief
+ *          Same as BMP_GETPIXEL(..) for 4bpp mode (real X resolution).
+ */
+#define BMP_GETPIXEL_4BPP(x, y)         ((BMP_GETPIXEL(x, y) >> ((((x) & 1) ^ 1) << 2)) & 0xF)
+/**
+ *  \brief
+ *          Same as BMP_GETPIXEL_TILE(..) for 4bpp mode (real X resolution).
+ */
+#define BMP_GETPIXEL_TILE_4BPP(x, y)    ((BMP_GETPIXEL_TILE(x, y) >> ((((x) & 1) ^ 1) << 2)) & 0xF)
+/**
+ *  \brief
+ *          Same as BMP_SETPIXEL(..) for 4bpp mode (real X resolution), col should be in 0-15 range.
+ */
+#define BMP_SETPIXEL_4BPP(x, y, col)        BMP_SETNIBBLE(&bmp_buffer_write[((y) * BMP_PITCH) + ((x) >> 1)], x, col)
+/**
+ *  \brief
+ *          Same as BMP_SETPIXEL_TILE(..) for 4bpp mode (real X resolution), col should be in 0-15 range.
+ */
+#define BMP_SETPIXEL_TILE_4BPP(x, y, col)   BMP_SETNIBBLE(&bmp_buffer_write[BMP_TILEOFFSET((x) >> 1, y)], x, col)
 
 
 #define BMP_BASETILEINDEX       TILE_USERINDEX
@@ -261,6 +352,14 @@ extern u8 *bmp_buffer_read;
  *      Current bitmap write buffer.
  */
 extern u8 *bmp_buffer_write;
+/**
+ *      Current bitmap width (in pixel).
+ */
+extern u16 bmp_width;
+/**
+ *      Current bitmap height (in pixel).
+ */
+extern u16 bmp_height;
 
 
 /**
@@ -282,6 +381,51 @@ extern u8 *bmp_buffer_write;
  * Requires ~41 KB of memory which is dynamically allocated.
  */
 void BMP_init(u16 double_buffer, u16 palette, u16 priority);
+/**
+ *  \brief
+ *      Initialize the software bitmap engine with extended options.
+ *
+ *  \param flags
+ *      Bitmap options:<br>
+ *      BMP_FLAG_DOUBLEBUFFER = enable VRAM double buffer (see BMP_init(..)).<br>
+ *      BMP_FLAG_TILEORDER = bitmap buffer is stored in VRAM tile order so it can be sent with DMA
+ *      (much faster flip). Pixels of a scanline are not contiguous anymore (only by group of 4 bytes)
+ *      so direct buffer accesses should use BMP_TILEOFFSET(..).<br>
+ *      BMP_FLAG_DIRTYROWS = flip only transfers tile rows (8 scanlines) modified by drawing methods.
+ *      Direct buffer writes (BMP_SETPIXEL(..), BMP_getWritePointer(..)...) are not tracked so
+ *      they should be declared with BMP_markDirty(..).<br>
+ *      BMP_FLAG_4BPP = pixel, line and polygon methods use real X resolution and 4 bits colors (0-15)
+ *      instead of doubled pixels and byte colors. Bitmap drawing methods are not affected.
+ *  \param palette
+ *      Palette index to use to render the bitmap plan.
+ *  \param priority
+ *      Set the priority of bitmap plan.
+ *  \param w
+ *      Bitmap width in pixel (multiple of 8, BMP_WIDTH maximum).<br>
+ *      The bitmap is horizontally centered on screen.
+ *  \param h
+ *      Bitmap height in pixel (multiple of 8, BMP_HEIGHT maximum).<br>
+ *      The bitmap is vertically centered on screen, remaining scanlines are used as extended blank
+ *      so a smaller height gives a faster flip.
+ *
+ * Buffer scanline pitch is always BMP_PITCH whatever is the bitmap width.
+ */
+void BMP_initEx(u16 flags, u16 palette, u16 priority, u16 w, u16 h);
+/**
+ *  \brief
+ *      Returns bitmap options (see BMP_initEx(..)).
+ */
+u16  BMP_getFlags();
+/**
+ *  \brief
+ *      Returns current bitmap width (in pixel).
+ */
+u16  BMP_getWidth();
+/**
+ *  \brief
+ *      Returns current bitmap height (in pixel).
+ */
+u16  BMP_getHeight();
 /**
  *  \brief
  *      End the software bitmap engine.
@@ -328,6 +472,19 @@ u16 BMP_flip(u16 async);
  *      Clear bitmap buffer.
  */
 void BMP_clear();
+/**
+ *  \brief
+ *      Mark scanlines of bitmap buffer as modified.
+ *
+ *  \param y
+ *      First scanline.
+ *  \param h
+ *      Number of scanline.
+ *
+ * Only required in dirty rows mode (see BMP_initEx(..)) after direct buffer writes,
+ * drawing methods already track the area they modify.
+ */
+void BMP_markDirty(u16 y, u16 h);
 
 /**
  *  \brief
@@ -339,7 +496,8 @@ void BMP_clear();
  *      Y pixel coordinate.
  *
  * As coordinates are expressed for 4bpp pixel BMP_getWritePointer(0,0)
- * and BMP_getWritePointer(1,0) actually returns the same address.
+ * and BMP_getWritePointer(1,0) actually returns the same address.<br>
+ * In tile order mode only 4 bytes (8 pixels) are contiguous, next ones are 32 bytes away.
  */
 u8*  BMP_getWritePointer(u16 x, u16 y);
 /**
@@ -352,7 +510,8 @@ u8*  BMP_getWritePointer(u16 x, u16 y);
  *      Y pixel coordinate.
  *
  * As coordinates are expressed for 4bpp pixel BMP_getReadPointer(0,0)
- * and BMP_getReadPointer(1,0) actually returns the same address.
+ * and BMP_getReadPointer(1,0) actually returns the same address.<br>
+ * In tile order mode only 4 bytes (8 pixels) are contiguous, next ones are 32 bytes away.
  */
 u8*  BMP_getReadPointer(u16 x, u16 y);
 
@@ -432,7 +591,8 @@ void BMP_showFPS(u16 float_display);
  *      Y coordinate.
  *
  * Pixels are rendereded with X doubled resolution (byte operation) for performance reason.<br>
- * So BMP_getPixel(0,0) will actually returns same value as BMP_getPixel(1,0).
+ * So BMP_getPixel(0,0) will actually returns same value as BMP_getPixel(1,0).<br>
+ * In 4bpp mode (see BMP_initEx(..)) the 4 bits pixel value is returned.
  *
  *  \see #BMP_GETPIXEL (faster but not as safe)
  */
@@ -449,7 +609,8 @@ u8   BMP_getPixel(u16 x, u16 y);
  *      pixel color.
  *
  * Pixels are rendereded with X doubled resolution (byte operation) for performance reason.<br>
- * So BMP_setPixel(0,0,..) will actually set same pixel as BMP_setPixel(1,0,..).
+ * So BMP_setPixel(0,0,..) will actually set same pixel as BMP_setPixel(1,0,..).<br>
+ * In 4bpp mode (see BMP_initEx(..)) only the 4 bits pixel is written (col = 0-15).
  *
  *  \see #BMP_SETPIXEL (faster but not as safe)
  */
@@ -502,7 +663,8 @@ u8   BMP_clipLine(Line *l);
  *      Line to draw.
  *
  * Lines are rendereded with X doubled resolution (byte operation) for performance reason.<br>
- * So BMP_drawLine(0,0,0,159) will actually draw same line as BMP_drawLine(1,0,1,159).
+ * So BMP_drawLine(0,0,0,159) will actually draw same line as BMP_drawLine(1,0,1,159).<br>
+ * In 4bpp mode (see BMP_initEx(..)) lines use real X resolution and 4 bits color (0-15).
  */
 void BMP_drawLine(Line *l);
 /**
@@ -529,10 +691,74 @@ u16 BMP_isPolygonCulled(const Vect2D_s16 *pts, u16 num);
  *  \param num
  *      number of point (lenght of points buffer).
  *  \param col
- *      fill color.
+ *      fill color (byte color for even and odd pixels, 4 bits color in 4bpp mode).
  *  \return 0 if polygon was not drawn (outside screen or whatever).
+ *
+ * In tile order mode, polygon wider or higher than 16383 pixels is not drawn.
  */
 u16 BMP_drawPolygon(const Vect2D_s16 *pts, u16 num, u8 col);
+/**
+ *  \brief
+ *      Draw a color interpolated (gouraud) triangle.
+ *
+ *  \param pts
+ *      Triangle points buffer (3 points, any order).
+ *  \param cols
+ *      Color of each point (0-15), the palette should contain a color ramp.<br>
+ *      Intermediate colors are rendered with a 4x4 ordered dithering.
+ *  \return 0 if triangle was not drawn (outside screen, empty or too large).
+ *
+ * The triangle is filled with the same edges and clipping as BMP_drawPolygon(..) so adjacent
+ * triangles can share edge pixels.<br>
+ * Triangle wider or higher than 16383 pixels is not drawn (points can be far outside screen below that).<br>
+ * In X doubled mode color is interpolated per byte (2 pixels).
+ */
+u16 BMP_drawTriangleShaded(const Vect2D_s16 *pts, const u8 *cols);
+/**
+ *  \brief
+ *      Draw a color interpolated (gouraud) quad.
+ *
+ *  \param pts
+ *      Quad points buffer (4 points in clockwise or counter clockwise order, should be convex).
+ *  \param cols
+ *      Color of each point (0-15).
+ *  \return 0 if quad was not drawn (outside screen or empty).
+ *
+ * The quad is drawn as 2 triangles (0,1,2) and (0,2,3), see BMP_drawTriangleShaded(..).
+ */
+u16 BMP_drawQuadShaded(const Vect2D_s16 *pts, const u8 *cols);
+/**
+ *  \brief
+ *      Draw an affine texture mapped triangle.
+ *
+ *  \param pts
+ *      Triangle points buffer (3 points, any order).
+ *  \param uvs
+ *      Texture coordinates (in texel) of each point.
+ *  \param texture
+ *      Texture bitmap, should not be compressed, its width and height should be a power of 2
+ *      (texture coordinates wrap) and its size should not exceed 32 KB.
+ *  \return 0 if triangle was not drawn (outside screen, empty or unsupported texture).
+ *
+ * Same filling rules as BMP_drawTriangleShaded(..).<br>
+ * In X doubled mode one texel is sampled per byte (2 pixels).
+ */
+u16 BMP_drawTriangleTextured(const Vect2D_s16 *pts, const Vect2D_s16 *uvs, const Bitmap *texture);
+/**
+ *  \brief
+ *      Draw an affine texture mapped quad.
+ *
+ *  \param pts
+ *      Quad points buffer (4 points in clockwise or counter clockwise order, should be convex).
+ *  \param uvs
+ *      Texture coordinates (in texel) of each point.
+ *  \param texture
+ *      Texture bitmap (see BMP_drawTriangleTextured(..)).
+ *  \return 0 if quad was not drawn (outside screen, empty or unsupported texture).
+ *
+ * The quad is drawn as 2 triangles (0,1,2) and (0,2,3), see BMP_drawTriangleTextured(..).
+ */
+u16 BMP_drawQuadTextured(const Vect2D_s16 *pts, const Vect2D_s16 *uvs, const Bitmap *texture);
 
 /**
  *  \brief
@@ -31,6 +31,14 @@
  */
 #define FAT16_SUPPORT       0
 
+/**
+ *  \brief
+ *      Size (in tile) of the tile cache unpack buffer (32 bytes of RAM per tile).<br>
+ *      Compressed TileSet uploaded by the tile cache are unpacked in this fixed buffer instead of
+ *      a temporary allocated one so peak memory usage stays constant.
+ */
+#define TC_UNPACK_BUFFER_SIZE   64
+
 /**
  *  \brief
  *      Set it to 1 if you want to have the kit intro logo
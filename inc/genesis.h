@@ -30,7 +30,16 @@
 
 #include "bmp.h"
 #include "tile_cache.h"
+#include "vram.h"
 #include "sprite_eng.h"
+#include "map_eng.h"
+#include "parallax.h"
+#include "tilemap_buf.h"
+#include "hud.h"
+#include "tile_anim.h"
+#include "tile_loader.h"
+#include "pal_fx.h"
+#include "pal_alloc.h"
 
 #include "sound.h"
 #include "tfcplay.h"
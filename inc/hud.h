@@ -0,0 +1,199 @@
+/**
+ *  \file hud.h
+ *  \brief Window plan HUD
+ *
+ * This unit displays a HUD (score, timer, life bar...) in the window plan, at top or bottom of the screen.<br/>
+ * HUD content is drawn in a tilemap buffer (see tilemap_buf.h file) so only modified cells are sent to VRAM
+ * through the DMA queue at VBlank.<br/>
+ * Widgets (HudNumber, HudBar) keep their last displayed value and do nothing if it did not change, so they
+ * can be updated every frame for free.
+ */
+
+#ifndef _HUD_H_
+#define _HUD_H_
+
+#include "vdp.h"
+#include "tilemap_buf.h"
+
+
+/**
+ *  \brief
+ *      Maximum length of a number widget (in character).
+ */
+#define HUD_NUMBER_MAX_LEN  10
+
+
+/**
+ *  \brief
+ *      Number widget.
+ *
+ *  \param x
+ *      X position in HUD (in tile).
+ *  \param y
+ *      Y position in HUD (in tile).
+ *  \param len
+ *      Number of character (number is right aligned).
+ *  \param flags
+ *      Tile attributes for characters (see TILE_ATTR() macro).
+ *  \param zeroPad
+ *      Fill unused characters with '0' instead of space.
+ *  \param value
+ *      Last displayed value.
+ *  \param drawn
+ *      Widget has been drawn at least once.
+ */
+typedef struct
+{
+    u16 x;
+    u16 y;
+    u16 len;
+    u16 flags;
+    u16 zeroPad;
+    u32 value;
+    u16 drawn;
+} HudNumber;
+
+/**
+ *  \brief
+ *      Bar widget (life bar, power gauge...).
+ *
+ *  \param x
+ *      X position in HUD (in tile).
+ *  \param y
+ *      Y position in HUD (in tile).
+ *  \param len
+ *      Bar length (in tile).
+ *  \param basetile
+ *      Base index and flags of the bar tiles (see TILE_ATTR_FULL() macro).<br/>
+ *      9 tiles are expected from this index: empty tile then tiles filled with 1 to 8 pixel columns.
+ *  \param max
+ *      Value of a full bar.
+ *  \param fill
+ *      Last displayed fill level (in pixel).
+ *  \param drawn
+ *      Widget has been drawn at least once.
+ */
+typedef struct
+{
+    u16 x;
+    u16 y;
+    u16 len;
+    u16 basetile;
+    u16 max;
+    u16 fill;
+    u16 drawn;
+} HudBar;
+
+
+/**
+ *  \brief
+ *      Initialize the HUD and enable the window plan on the HUD area.
+ *
+ *  \param h
+ *      HUD height (in tile).
+ *  \param bottom
+ *      Place the HUD at bottom of the screen instead of top.
+ *  \return
+ *      FALSE if the HUD buffer could not be allocated.
+ *
+ *  HUD width is the screen width, the HUD is cleared on next VBlank.
+ */
+u16 HUD_init(u16 h, u16 bottom);
+/**
+ *  \brief
+ *      Disable the window plan and release the HUD buffer.
+ */
+void HUD_end();
+/**
+ *  \brief
+ *      Returns the HUD tilemap buffer (to draw custom content with TMB_xxx methods).
+ */
+TileMapBuffer *HUD_getBuffer();
+
+/**
+ *  \brief
+ *      Draw text in the HUD (only modified characters are sent to VRAM).
+ *
+ *  \param str
+ *      String to draw.
+ *  \param flags
+ *      Tile attributes for characters (see TILE_ATTR() macro).
+ *  \param x
+ *      X position in HUD (in tile).
+ *  \param y
+ *      Y position in HUD (in tile).
+ */
+void HUD_drawText(const char *str, u16 flags, u16 x, u16 y);
+/**
+ *  \brief
+ *      Clear text in the HUD.
+ *
+ *  \param x
+ *      X position in HUD (in tile).
+ *  \param y
+ *      Y position in HUD (in tile).
+ *  \param w
+ *      Number of character to clear.
+ */
+void HUD_clearText(u16 x, u16 y, u16 w);
+
+/**
+ *  \brief
+ *      Initialize a number widget (nothing is drawn until first HUD_setNumber(..) call).
+ *
+ *  \param number
+ *      Number widget to initialize.
+ *  \param x
+ *      X position in HUD (in tile).
+ *  \param y
+ *      Y position in HUD (in tile).
+ *  \param len
+ *      Number of character (HUD_NUMBER_MAX_LEN max).
+ *  \param flags
+ *      Tile attributes for characters (see TILE_ATTR() macro).
+ *  \param zeroPad
+ *      Fill unused characters with '0' instead of space.
+ */
+void HUD_initNumber(HudNumber *number, u16 x, u16 y, u16 len, u16 flags, u16 zeroPad);
+/**
+ *  \brief
+ *      Set number widget value (does nothing if value did not change).
+ *
+ *  \param number
+ *      Number widget.
+ *  \param value
+ *      Value to display.
+ */
+void HUD_setNumber(HudNumber *number, u32 value);
+
+/**
+ *  \brief
+ *      Initialize a bar widget (nothing is drawn until first HUD_setBar(..) call).
+ *
+ *  \param bar
+ *      Bar widget to initialize.
+ *  \param x
+ *      X position in HUD (in tile).
+ *  \param y
+ *      Y position in HUD (in tile).
+ *  \param len
+ *      Bar length (in tile).
+ *  \param basetile
+ *      Base index and flags of the 9 bar tiles (see HudBar).
+ *  \param max
+ *      Value of a full bar.
+ */
+void HUD_initBar(HudBar *bar, u16 x, u16 y, u16 len, u16 basetile, u16 max);
+/**
+ *  \brief
+ *      Set bar widget value (does nothing if the displayed fill level did not change).
+ *
+ *  \param bar
+ *      Bar widget.
+ *  \param value
+ *      Value to display (clipped to bar maximum).
+ */
+void HUD_setBar(HudBar *bar, u16 value);
+
+
+#endif // _HUD_H_
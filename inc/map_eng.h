@@ -0,0 +1,232 @@
+/**
+ *  \file map_eng.h
+ *  \brief Map streaming engine
+ *
+ * Map streaming engine to scroll large Map through a (small) VDP plan.<br/>
+ * The plan is used as a wrapping buffer: each frame only the newly exposed tilemap columns and rows
+ * are sent to VRAM through the DMA queue (see dma.h file) so scrolling a large level only costs
+ * a few hundred bytes of VRAM transfer per frame.<br/>
+ * The engine uses plain scroll mode and requires the plan to be larger than the screen
+ * (64x32 plan for a 320x224 screen for instance).<br/>
+ * A Map using COMPRESSION_MAP_BLOCK compression stays compressed in ROM: only the blocks intersecting
+ * the view are unpacked in a small block cache (see MAP_BLOCK_CACHE) so RAM usage does not depend on Map size.<br/>
+ * The engine can also render a MetaMap (Map defined with metatiles, see METAMAP resource in rescomp.txt)
+ * using MAP_initMeta(..), metatiles are expanded while streaming the newly exposed columns and rows.
+ */
+
+#ifndef _MAP_ENG_H_
+#define _MAP_ENG_H_
+
+#include "vdp.h"
+#include "vdp_tile.h"
+#include "vdp_pal.h"
+
+
+/**
+ *  \brief
+ *      Maximum number of column and row the engine can update per frame (so maximum scroll speed is 16 pixels per frame).<br/>
+ *      Above that the whole screen is redrawn.
+ */
+#define MAP_MAX_UPDATE      2
+/**
+ *  \brief
+ *      Maximum number of tile column visible on screen (320 pixels wide screen + 1 partial column).
+ */
+#define MAP_MAX_VIEW_W      42
+/**
+ *  \brief
+ *      Maximum number of tile row visible on screen (240 pixels high screen + 1 partial row).
+ */
+#define MAP_MAX_VIEW_H      32
+/**
+ *  \brief
+ *      Number of unpacked Map block the engine can keep for COMPRESSION_MAP_BLOCK Map (4x3 blocks cover the whole view).<br/>
+ *      Each block requires (MAP_BLOCK_SIZE * MAP_BLOCK_SIZE * 2) bytes of memory.
+ */
+#define MAP_BLOCK_CACHE     12
+
+
+/**
+ *  \brief
+ *      MetaMap structure which contains a background defined with metatiles (block of tiles).<br/>
+ *      A metatile is a square block of (metaSize x metaSize) tilemap entries, the block map references
+ *      metatiles so the whole tilemap is never stored.
+ *
+ *  \param palette
+ *      Palette data.
+ *  \param tileset
+ *      TileSet data structure (contains tiles definition for the metatiles).
+ *  \param metaSize
+ *      Metatile size in tile (2 = 16x16 pixels metatile, 4 = 32x32 pixels metatile).
+ *  \param numMetaTile
+ *      Number of metatile in the metatile dictionary.
+ *  \param w
+ *      Block map width in metatile.
+ *  \param h
+ *      Block map height in metatile.
+ *  \param metatiles
+ *      Metatile dictionary (numMetaTile * metaSize * metaSize tilemap entries, row ordered).
+ *  \param blockmap
+ *      Block map data (metatile index).
+ */
+typedef struct
+{
+    Palette *palette;
+    TileSet *tileset;
+    u16 metaSize;
+    u16 numMetaTile;
+    u16 w;
+    u16 h;
+    u16 *metatiles;
+    u16 *blockmap;
+} MetaMap;
+
+/**
+ *  \brief
+ *      Map scroller structure, used to stream a Map in a VDP plan.
+ *
+ *  \param map
+ *      Source Map (NULL if we are using a MetaMap).
+ *  \param metamap
+ *      Source MetaMap (NULL if we are using a Map).
+ *  \param w
+ *      Map width in tile.
+ *  \param h
+ *      Map height in tile.
+ *  \param metaShift
+ *      Metatile size shift (MetaMap only).
+ *  \param tilemap
+ *      Tilemap data we are reading from (unpacked data for compressed Map, NULL for COMPRESSION_MAP_BLOCK Map).
+ *  \param unpacked
+ *      Unpacked Map (if source Map was compressed), released with MAP_release(..).
+ *  \param blocks
+ *      Unpacked block buffer (COMPRESSION_MAP_BLOCK Map only), released with MAP_release(..).
+ *  \param blockIds
+ *      Map block stored in each block cache entry (-1 = empty).
+ *  \param blockUse
+ *      Last use time of each block cache entry (used to find the least recently used entry).
+ *  \param blockTime
+ *      Block cache time counter.
+ *  \param plan
+ *      VDP plan used to display the Map.
+ *  \param basetile
+ *      Base tile index and flags for tilemap data (see TILE_ATTR_FULL() macro).
+ *  \param x
+ *      Current camera X position (in pixel).
+ *  \param y
+ *      Current camera Y position (in pixel).
+ *  \param tileX
+ *      First visible tile column (in Map).
+ *  \param tileY
+ *      First visible tile row (in Map).
+ *  \param hScroll
+ *      Horizontal scroll value sent to VDP.
+ *  \param vScroll
+ *      Vertical scroll value sent to VDP.
+ *  \param colBuffer
+ *      Tilemap column buffers (DMA source).
+ *  \param rowBuffer
+ *      Tilemap row buffers (DMA source).
+ */
+typedef struct
+{
+    const Map *map;
+    const MetaMap *metamap;
+    u16 w;
+    u16 h;
+    u16 metaShift;
+    const u16 *tilemap;
+    Map *unpacked;
+    u16 *blocks;
+    s16 blockIds[MAP_BLOCK_CACHE];
+    u16 blockUse[MAP_BLOCK_CACHE];
+    u16 blockTime;
+    VDPPlan plan;
+    u16 basetile;
+    s16 x;
+    s16 y;
+    s16 tileX;
+    s16 tileY;
+    s16 hScroll;
+    s16 vScroll;
+    u16 colBuffer[MAP_MAX_UPDATE][MAP_MAX_VIEW_H];
+    u16 rowBuffer[MAP_MAX_UPDATE][MAP_MAX_VIEW_W];
+} MapScroller;
+
+
+/**
+ *  \brief
+ *      Initialize the map scroller and draw the Map in the plan at the specified camera position.
+ *
+ *  \param scroller
+ *      Map scroller to initialize.
+ *  \param map
+ *      Map to display.<br/>
+ *      A compressed Map is unpacked once in memory except if it uses COMPRESSION_MAP_BLOCK compression,
+ *      in which case blocks are unpacked on demand.
+ *  \param plan
+ *      Plan where we want to display the Map.<br/>
+ *      Accepted values are:<br/>
+ *      - PLAN_A<br/>
+ *      - PLAN_B<br/>
+ *  \param basetile
+ *      Base index and flag for tile reference in tilemap (see TILE_ATTR_FULL() macro).
+ *  \param x
+ *      Camera X position (in pixel).
+ *  \param y
+ *      Camera Y position (in pixel).
+ *  \return
+ *      FALSE if the Map (or the block cache) could not be allocated (not enough memory).
+ */
+u16 MAP_init(MapScroller *scroller, const Map *map, VDPPlan plan, u16 basetile, s16 x, s16 y);
+/**
+ *  \brief
+ *      Initialize the map scroller with a MetaMap and draw it in the plan at the specified camera position.
+ *
+ *  \param scroller
+ *      Map scroller to initialize.
+ *  \param metamap
+ *      MetaMap to display (metatile size should be a power of 2).
+ *  \param plan
+ *      Plan where we want to display the MetaMap.<br/>
+ *      Accepted values are:<br/>
+ *      - PLAN_A<br/>
+ *      - PLAN_B<br/>
+ *  \param basetile
+ *      Base index and flag for tile reference in metatiles (see TILE_ATTR_FULL() macro).
+ *  \param x
+ *      Camera X position (in pixel).
+ *  \param y
+ *      Camera Y position (in pixel).
+ *
+ *  The MetaMap tileset should be loaded in VRAM at <i>basetile</i> index before (see VDP_loadTileSet(..)).
+ */
+void MAP_initMeta(MapScroller *scroller, const MetaMap *metamap, VDPPlan plan, u16 basetile, s16 x, s16 y);
+/**
+ *  \brief
+ *      Release memory used by the map scroller (unpacked Map or block cache).
+ *
+ *  \param scroller
+ *      Map scroller to release.
+ */
+void MAP_release(MapScroller *scroller);
+/**
+ *  \brief
+ *      Move the camera to the specified position.<br/>
+ *      Newly exposed tilemap columns and rows and scroll values are sent through the DMA queue
+ *      so this method should be called once per frame (DMA source buffers are reused on next call).<br/>
+ *      When the DMA queue is full, columns and rows are written directly to VRAM.<br/>
+ *      On a move larger than MAP_MAX_UPDATE tiles, the display is disabled while the whole view and
+ *      scroll values are written directly to VRAM (current frame is partially blanked).
+ *
+ *  \param scroller
+ *      Map scroller.
+ *  \param x
+ *      Camera X position (in pixel), clipped to Map bounds.
+ *  \param y
+ *      Camera Y position (in pixel), clipped to Map bounds.
+ */
+void MAP_scrollTo(MapScroller *scroller, s16 x, s16 y);
+
+
+#endif // _MAP_ENG_H_
@@ -81,9 +81,9 @@ u16  M3D_getLightEnabled();
  *      Set viewport dimension.
  *
  *  \param w
- *      Viewport width (use BMP_WIDTH if you use 3D with software bitmap engine)
+ *      Viewport width (use BMP_getWidth() if you use 3D with software bitmap engine)
  *  \param h
- *      Viewport height (use BMP_HEIGHT if you use 3D with software bitmap engine)
+ *      Viewport height (use BMP_getHeight() if you use 3D with software bitmap engine)
  */
 void M3D_setViewport(u16 w, u16 h);
 /**
@@ -0,0 +1,84 @@
+/**
+ *  \file pal_alloc.h
+ *  \brief Hardware palette allocation manager
+ *
+ * This unit shares the 4 hardware palettes (PAL0-PAL3) between sprites (or any other user).<br/>
+ * Each managed hardware palette (slot) is reference counted: requesting a palette already loaded
+ * in a slot (same Palette or identical colors) just returns this slot, otherwise a free slot is assigned
+ * and colors are uploaded to CRAM.<br/>
+ * Released slots keep their colors so requesting the same palette again later doesn't need any upload,
+ * they are only reassigned when no free slot with unknown content is left (oldest released first).
+ */
+
+#ifndef _PAL_ALLOC_H_
+#define _PAL_ALLOC_H_
+
+#include "vdp_pal.h"
+#include "sprite_eng.h"
+
+
+/**
+ *  \brief
+ *      Initialize the palette allocation manager.
+ *
+ *  \param firstPal
+ *      First hardware palette to manage (PAL0-PAL3).
+ *  \param numPal
+ *      Number of hardware palette to manage.
+ *
+ *  Use PAL_init(PAL1, 3) for instance to keep PAL0 for background.
+ */
+void PAL_init(u16 firstPal, u16 numPal);
+
+/**
+ *  \brief
+ *      Request a hardware palette for the specified palette (reference count is incremented).
+ *
+ *  \param pal
+ *      Palette to load (should stay valid while it is allocated).
+ *  \return
+ *      Hardware palette (PAL0-PAL3) holding the palette or -1 if all managed palettes are in use.
+ *
+ *  Palette colors are uploaded to CRAM only if the palette wasn't already present in a slot.<br/>
+ *  Upload goes through the DMA queue so new colors are visible from next VBlank, colors which
+ *  don't fit in the 16 colors slot (index + length > 16) are ignored.
+ */
+s16 PAL_alloc(const Palette *pal);
+/**
+ *  \brief
+ *      Release a hardware palette (reference count is decremented).
+ *
+ *  \param numPal
+ *      Hardware palette (PAL0-PAL3) returned by PAL_alloc(..).
+ */
+void PAL_release(u16 numPal);
+/**
+ *  \brief
+ *      Returns the reference count of the specified hardware palette.
+ *
+ *  \param numPal
+ *      Hardware palette (PAL0-PAL3).
+ */
+u16 PAL_getRefCount(u16 numPal);
+
+/**
+ *  \brief
+ *      Request a hardware palette for the sprite definition palette and set the sprite palette attribute.
+ *
+ *  \param sprite
+ *      Sprite (should be initialized).
+ *  \return
+ *      FALSE if all managed palettes are in use (sprite attribute is not modified).
+ */
+u16 PAL_allocSprite(Sprite *sprite);
+/**
+ *  \brief
+ *      Release the hardware palette used by the sprite (from its palette attribute).
+ *
+ *  \param sprite
+ *      Sprite previously passed to PAL_allocSprite(..).
+ */
+void PAL_releaseSprite(Sprite *sprite);
+
+
+#endif // _PAL_ALLOC_H_
@@ -0,0 +1,191 @@
+/**
+ *  \file pal_fx.h
+ *  \brief Palette effects (color cycling, flash, raster palette split)
+ *
+ * This unit keeps a RAM copy (shadow) of the whole CRAM and applies palette effects on it:<br/>
+ * - color cycling (rotation of a color range, water / lava / conveyor effects).<br/>
+ * - timed flash (a color range is replaced by a single color for a few frames).<br/>
+ * - raster palette split (some colors are changed at a given scanline from H-Int).<br/>
+ * Modified colors are only marked as dirty, at VBlank all changes are sent with a single CRAM transfer
+ * through the DMA queue (see dma.h file).<br/>
+ * While palette effects are active, colors should be modified with PFX_setColors(..) instead of
+ * VDP_setPaletteColors(..) otherwise they will be overwritten by the shadow content.<br/>
+ * Raster split uses the H-Int counter so it can't be used with the BMP engine
+ * and it changes the VDP address from H-Int (see PFX_setSplit(..)).
+ */
+
+#ifndef _PAL_FX_H_
+#define _PAL_FX_H_
+
+#include "vdp.h"
+#include "vdp_pal.h"
+
+
+/**
+ *  \brief
+ *      Maximum number of color cycling running at same time.
+ */
+#define PFX_MAX_CYCLE       8
+/**
+ *  \brief
+ *      Maximum number of flash running at same time.
+ */
+#define PFX_MAX_FLASH       4
+/**
+ *  \brief
+ *      Maximum number of color changed by the raster split.
+ */
+#define PFX_MAX_SPLIT_COLOR 16
+
+
+/**
+ *  \brief
+ *      Color cycling structure.
+ *
+ *  \param from
+ *      First color index of the range.
+ *  \param to
+ *      Last color index of the range.
+ *  \param delay
+ *      Number of frame between 2 rotations.
+ *  \param timer
+ *      Remaining frame before next rotation.
+ *  \param reverse
+ *      Rotation direction (FALSE: colors move to higher index).
+ */
+typedef struct
+{
+    u16 from;
+    u16 to;
+    u16 delay;
+    u16 timer;
+    u16 reverse;
+} PaletteCycle;
+
+
+/**
+ *  \brief
+ *      Initialize palette effects.<br/>
+ *      The shadow palette is initialized from current CRAM content.
+ */
+void PFX_init();
+/**
+ *  \brief
+ *      Stop all palette effects (and the raster split).
+ */
+void PFX_end();
+
+/**
+ *  \brief
+ *      Returns color from the shadow palette.
+ *
+ *  \param index
+ *      Color index (0-63).
+ */
+u16 PFX_getColor(u16 index);
+/**
+ *  \brief
+ *      Set a color in the shadow palette (sent on next VBlank).
+ *
+ *  \param index
+ *      Color index (0-63).
+ *  \param value
+ *      RGB intensity.
+ */
+void PFX_setColor(u16 index, u16 value);
+/**
+ *  \brief
+ *      Set colors in the shadow palette (sent on next VBlank).
+ *
+ *  \param index
+ *      Color index where to start to write (0-63).
+ *  \param values
+ *      RGB intensities to set.
+ *  \param count
+ *      Number of color to set.
+ */
+void PFX_setColors(u16 index, const u16 *values, u16 count);
+
+/**
+ *  \brief
+ *      Start a color cycling.
+ *
+ *  \param cycle
+ *      Color cycling structure (should stay valid until the cycling is stopped).
+ *  \param from
+ *      First color index of the range (0-63).
+ *  \param to
+ *      Last color index of the range (0-63 and > from).
+ *  \param delay
+ *      Number of frame between 2 rotations (1 = rotate each frame).
+ *  \param reverse
+ *      Rotation direction (FALSE: colors move to higher index).
+ *  \return
+ *      FALSE if PFX_MAX_CYCLE color cycling are already running.
+ */
+u16 PFX_startCycle(PaletteCycle *cycle, u16 from, u16 to, u16 delay, u16 reverse);
+/**
+ *  \brief
+ *      Stop a color cycling (colors keep their current position).
+ *
+ *  \param cycle
+ *      Color cycling to stop.
+ */
+void PFX_stopCycle(PaletteCycle *cycle);
+
+/**
+ *  \brief
+ *      Flash a color range (shadow palette is not modified and restored when the flash ends).
+ *
+ *  \param from
+ *      First color index of the range (0-63).
+ *  \param to
+ *      Last color index of the range (0-63 and >= from).
+ *  \param color
+ *      Flash color.
+ *  \param duration
+ *      Flash duration in number of frame (PFX_update(..) call).
+ *  \return
+ *      FALSE if PFX_MAX_FLASH flash are already running.
+ */
+u16 PFX_flash(u16 from, u16 to, u16 color, u16 duration);
+
+/**
+ *  \brief
+ *      Set raster palette split: colors are replaced from the specified scanline to the bottom of the screen.<br/>
+ *      Shadow colors are restored at each VBlank so the top of the screen is not affected.
+ *
+ *  \param line
+ *      Scanline where colors change (1 - screen height).
+ *  \param index
+ *      First color index to change (0-63).
+ *  \param colors
+ *      New colors.
+ *  \param count
+ *      Number of color to change (max = PFX_MAX_SPLIT_COLOR).
+ *
+ *  Only one split is supported: the H-Int counter is reloaded when the interrupt happens,
+ *  so a second split line can't be programmed from the first one without an extra interrupt.<br/>
+ *  Warning: colors are sent from H-Int by writing the CRAM address to the VDP control port.<br/>
+ *  If the main code is doing CPU VDP writes (tilemap, tiles or colors sent without DMA) when the
+ *  split line is reached, its VDP address is lost and the remaining data goes to CRAM.<br/>
+ *  While a split is active, do these writes during VBlank, use the DMA queue or protect them
+ *  with SYS_disableInts() / SYS_enableInts().<br/>
+ *  The VDP auto increment is set to 2 for the colors then restored to VDP_getAutoInc().
+ */
+void PFX_setSplit(u16 line, u16 index, const u16 *colors, u16 count);
+/**
+ *  \brief
+ *      Remove raster palette split.
+ */
+void PFX_clearSplit();
+
+/**
+ *  \brief
+ *      Advance color cycling and flash timers.<br/>
+ *      Should be called once per frame.
+ */
+void PFX_update();
+
+
+#endif // _PAL_FX_H_
@@ -0,0 +1,86 @@
+/**
+ *  \file parallax.h
+ *  \brief Line scroll parallax engine
+ *
+ * This unit provides a simple parallax engine based on the line scroll mode.<br/>
+ * The screen is cut in horizontal bands (from top to bottom), each band scrolls at its own
+ * speed relative to the camera.<br/>
+ * Each frame PARA_update(..) fills the horizontal scroll table of the plan (see VDP_getHorizontalScrollTable(..))
+ * in a single pass and queues it so it is sent to the VDP with a single DMA at next VBlank.
+ */
+
+#ifndef _PARALLAX_H_
+#define _PARALLAX_H_
+
+#include "vdp.h"
+#include "maths.h"
+
+
+/**
+ *  \brief
+ *      Parallax band definition.
+ *
+ *  \param height
+ *      Band height (in line).
+ *  \param speed
+ *      Band scroll speed relative to camera (FIX16(1) = same speed than camera, FIX16(0) = fixed band).
+ */
+typedef struct
+{
+    u16 height;
+    fix16 speed;
+} ParallaxBand;
+
+/**
+ *  \brief
+ *      Parallax structure.
+ *
+ *  \param plan
+ *      VDP plan the parallax is applied to.
+ *  \param bands
+ *      Band definitions (from top to bottom of the screen).
+ *  \param numBand
+ *      Number of band (bands exceeding the scroll table are ignored).
+ *  \param table
+ *      Horizontal scroll table of the plan.
+ */
+typedef struct
+{
+    VDPPlan plan;
+    const ParallaxBand *bands;
+    u16 numBand;
+    s16 *table;
+} Parallax;
+
+
+/**
+ *  \brief
+ *      Initialize a parallax and set horizontal scrolling mode to line scroll.
+ *
+ *  \param parallax
+ *      Parallax to initialize.
+ *  \param plan
+ *      Plan we want to apply the parallax to.<br/>
+ *      Accepted values are:<br/>
+ *      - PLAN_A<br/>
+ *      - PLAN_B<br/>
+ *  \param bands
+ *      Band definitions, from top to bottom of the screen (this array is not copied).
+ *  \param numBand
+ *      Number of band.
+ */
+void PARA_init(Parallax *parallax, VDPPlan plan, const ParallaxBand *bands, u16 numBand);
+/**
+ *  \brief
+ *      Compute scroll value of each band for the specified camera position and
+ *      queue the plan horizontal scroll table for next VBlank.
+ *
+ *  \param parallax
+ *      Parallax to update.
+ *  \param camX
+ *      Camera X position (in pixel).
+ */
+void PARA_update(Parallax *parallax, s16 camX);
+
+
+#endif // _PARALLAX_H_
@@ -15,6 +15,7 @@
 #include "vdp_pal.h"
 #include "vdp_tile.h"
 #include "vdp_spr.h"
+#include "tile_cache.h"
 
 
 /**
@@ -221,7 +222,9 @@ typedef struct
  *
  * Initialize the sprite engine.<br/>
  * This actually allocate memory for sprite cache and initialize the tile cache engine
- * if this is not already done.
+ * if this is not already done.<br/>
+ * If the VRAM manager is initialized (see vram.h) the sprite tile cache is created from it,
+ * otherwise the cache is located just before the system font in VRAM.
  */
 void SPR_init(u16 cacheSize);
 /**
@@ -239,6 +242,12 @@ void SPR_end();
  *      FALSE if sprite cache engine is not initialized.
  */
 u16 SPR_isInitialized();
+/**
+ *  \brief
+ *      Return the tile cache used by the Sprite engine.<br/>
+ *      Can be used to get cache information or change the cache size through the VRAM manager.
+ */
+TileCache* SPR_getTileCache();
 
 /**
  *  \brief
@@ -16,6 +16,10 @@
 #define PROCESS_TILECACHE_TASK      (1 << 2)
 #define PROCESS_DMA_TASK            (1 << 3)
 #define PROCESS_XGM_TASK            (1 << 4)
+#define PROCESS_SCROLL_TASK         (1 << 5)
+#define PROCESS_TILEMAP_TASK        (1 << 6)
+#define PROCESS_TILELOAD_TASK       (1 << 7)
+#define PROCESS_PALFX_TASK          (1 << 8)
 
 
 // internals V/H timer
@@ -0,0 +1,140 @@
+/**
+ *  \file tile_anim.h
+ *  \brief Animated background tiles
+ *
+ * This unit animates background tiles (water, conveyor belt, torch...) by rewriting their VRAM content.<br/>
+ * Animations come from the ANIMTILES resource (see rescomp.txt): each frame is a TileSet plus a duration,
+ * identical frames share the same TileSet.<br/>
+ * TA_update(..) queues the tile rewrites in the DMA queue (see dma.h file) and skips the transfer when
+ * the new frame data is already in VRAM.
+ */
+
+#ifndef _TILE_ANIM_H_
+#define _TILE_ANIM_H_
+
+#include "vdp.h"
+#include "vdp_tile.h"
+
+
+/**
+ *  \brief
+ *      Maximum number of tile animation running at same time.
+ */
+#define TA_MAX_ANIM     16
+
+
+/**
+ *  \brief
+ *      Animated tiles frame.
+ *
+ *  \param tileset
+ *      Frame tiles (identical frames point to the same TileSet).
+ *  \param timer
+ *      Frame duration (in number of TA_update(..) call), 0 means the animation stays on this frame.
+ */
+typedef struct
+{
+    TileSet *tileset;
+    u16 timer;
+} AnimTilesFrame;
+
+/**
+ *  \brief
+ *      Animated tiles resource structure.
+ *
+ *  \param numFrame
+ *      Number of frame.
+ *  \param numTile
+ *      Number of tile of each frame.
+ *  \param frames
+ *      Frames.
+ */
+typedef struct
+{
+    u16 numFrame;
+    u16 numTile;
+    AnimTilesFrame *frames;
+} AnimTiles;
+
+/**
+ *  \brief
+ *      Running tile animation.
+ *
+ *  \param anim
+ *      Animated tiles definition.
+ *  \param index
+ *      VRAM tile index of the animated tiles.
+ *  \param frame
+ *      Current frame.
+ *  \param timer
+ *      Remaining time for current frame.
+ *  \param paused
+ *      Animation is paused.
+ *  \param loaded
+ *      TileSet currently in VRAM (NULL if unknown).
+ */
+typedef struct
+{
+    const AnimTiles *anim;
+    u16 index;
+    u16 frame;
+    u16 timer;
+    u16 paused;
+    const TileSet *loaded;
+} TileAnimation;
+
+
+/**
+ *  \brief
+ *      Start a tile animation, first frame is queued on next TA_update(..) call.
+ *
+ *  \param animation
+ *      Tile animation to start.
+ *  \param anim
+ *      Animated tiles definition.
+ *  \param index
+ *      VRAM tile index where the animated tiles are located.
+ *  \return
+ *      FALSE if TA_MAX_ANIM animations are already running.
+ */
+u16 TA_start(TileAnimation *animation, const AnimTiles *anim, u16 index);
+/**
+ *  \brief
+ *      Stop a tile animation (tiles keep their current content).
+ *
+ *  \param animation
+ *      Tile animation to stop.
+ */
+void TA_stop(TileAnimation *animation);
+/**
+ *  \brief
+ *      Pause or resume a tile animation.
+ *
+ *  \param animation
+ *      Tile animation.
+ *  \param value
+ *      TRUE to pause animation, FALSE to resume it.
+ */
+void TA_setPaused(TileAnimation *animation, u16 value);
+/**
+ *  \brief
+ *      Set current frame of a tile animation.
+ *
+ *  \param animation
+ *      Tile animation.
+ *  \param frame
+ *      Frame index.
+ */
+void TA_setFrame(TileAnimation *animation, u16 frame);
+/**
+ *  \brief
+ *      Advance all running tile animations and queue the tile rewrites.<br/>
+ *      Should be called once per frame.
+ *
+ *  A frame is only transferred if its TileSet differs from the one already in VRAM.<br/>
+ *  If the DMA queue is full the transfer is retried on next call.
+ */
+void TA_update();
+
+
+#endif // _TILE_ANIM_H_
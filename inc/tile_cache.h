@@ -30,19 +30,26 @@ typedef enum
  *  \brief
  *      Tile cache bloc structure.
  *
- * Define information for a single tileset VRAM allocation bloc.
+ * Define information for a single tileset VRAM allocation bloc.<br/>
+ * <i>refCount</i> is the number of allocation (TC_alloc / TC_reAlloc) not yet released for the bloc.<br/>
+ * <i>lastUse</i> is the cache time of the last allocation, used to evict the least recently used bloc first.
  */
 typedef struct
 {
     TileSet *tileset;
     u16 index;
+    u16 refCount;
+    u16 lastUse;
 } TCBloc;
 
 /**
  *  \brief
  *      Tile cache information structure.
  *
- * Define cache information for a VRAM region dedicated to tile storage.
+ * Define cache information for a VRAM region dedicated to tile storage.<br/>
+ * <i>hashTable</i> is an open addressing hash table (keyed on TileSet address) giving
+ * the bloc index of any allocated TileSet so lookup is done in constant time.<br/>
+ * <i>time</i> is increased on each flush operation and is used for the LRU (least recently used) eviction policy.
  */
 typedef struct
 {
@@ -53,6 +60,9 @@ typedef struct
     u16 nextFlush;
     u16 numBloc;
     TCBloc *blocs;
+    u16 hashMask;
+    u16 *hashTable;
+    u16 time;
 } TileCache;
 
 
@@ -60,7 +70,7 @@ typedef struct
  *  \brief
  *      Initialize the TileSet cache engine.
  *
- * Allocate some memory and enable VInt process.
+ * Allocate some memory (upload queue and unpack buffer, see TC_UNPACK_BUFFER_SIZE) and enable VInt process.
  */
 void TC_init();
 /**
@@ -82,7 +92,7 @@ void TC_end();
  *  \param size
  *      Size in tile of the cache.
  *
- * Set parameters and allocate some memory for the cache (~1KB).
+ * Set parameters and allocate some memory for the cache (~1.8KB).
  */
 void TC_createCache(TileCache *cache, u16 startIndex, u16 size);
 /**
@@ -98,7 +108,7 @@ void TC_createCache(TileCache *cache, u16 startIndex, u16 size);
  *  \param numBloc
  *      Number of bloc of the cache.
  *
- * Set parameters and allocate some memory for the cache (~1KB).
+ * Set parameters and allocate some memory for the cache (~14 bytes per bloc).
  */
 void TC_createCacheEx(TileCache *cache, u16 startIndex, u16 size, u16 numBloc);
 /**
@@ -108,7 +118,7 @@ void TC_createCacheEx(TileCache *cache, u16 startIndex, u16 size, u16 numBloc);
  *  \param cache
  *      Cache we want to release.
  *
- * Release memory used by TileSet cache structure (~1 KB).
+ * Release memory used by TileSet cache structure (~1.8 KB).
  */
 void TC_releaseCache(TileCache *cache);
 /**
@@ -127,17 +137,33 @@ void TC_clearCache(TileCache *cache);
  *      Cache we want to flush.
 
  * This is not exactly the same as the clear operation:<br/>
- * Allocated tileset remains in cache but they can be erased with newly allocated tileset.
+ * Allocated tileset remains in cache but they can be erased with newly allocated tileset.<br/>
+ * Also increase the cache time so each flush defines a new "frame" for the LRU eviction policy.
  */
 void TC_flushCache(TileCache *cache);
+/**
+ *  \brief
+ *      Inform that all tile indexes obtained from the specified cache since last TC_flushCache(..) have been
+ *      sent to the VDP (or queued in the DMA queue).
+ *
+ *  \param cache
+ *      Cache we finished to update.
+ *
+ * Only required for a cache using automatic defragmentation (see TC_setAutoDefrag(..)), SPR_update(..) does it for the sprite cache.
+ */
+void TC_endUpdate(TileCache *cache);
 
 /**
  *  \brief
  *      Allocate the specified TileSet in VRAM with given Tile cache and return its index.<br>
- *      If TileSet is already present in VRAM, no special operation is done else
+ *      If TileSet is already present in VRAM its reference counter is increased else
  *      the TileSet will be automatically uploaded at the next VInt.<br>
- *      If the specified TileSet is compressed the method unpack it and store it
- *      in a temporary TileSet until it is send to VRAM.
+ *      When there is no free VRAM left, flushed blocs are evicted in least recently used order.<br>
+ *      If the specified TileSet is compressed the method unpack it in the tile cache unpack buffer
+ *      (see TC_UNPACK_BUFFER_SIZE) until it is send to VRAM. When the buffer is full, RLE TileSet are unpacked
+ *      directly in VRAM during VBlank (a few tiles per VBlank so it may take several frames) and others are
+ *      unpacked in a temporary allocated TileSet.<br>
+ *      With UPLOAD_NOW, RLE TileSet are always unpacked directly in VRAM.
  *
  *  \param cache
  *      Cache used for allocation.
@@ -150,7 +176,9 @@ void TC_flushCache(TileCache *cache);
  *      <b>UPLOAD_NOW</b> upload to VRAM now<br/>
  *  \return
  *      the index of the TileSet in VRAM.<br/>
- *      -1 if there is no enough available VRAM.
+ *      -1 if there is no enough available VRAM.<br/>
+ *      If the cache has been created with the VRAM manager (see vram.h) the cache first tries
+ *      to get more VRAM from the manager before failing.
  */
 s16 TC_alloc(TileCache *cache, TileSet *tileset, TCUpload upload);
 /**
@@ -172,8 +200,8 @@ s16 TC_reAlloc(TileCache *cache, TileSet *tileset);
 /**
  *  \brief
  *      Release VRAM allocation of the specified TileSet.<br>
- *      The tileSet remains in VRAM but will be the bloc will be marked as flushed so
- *      it can be overwritten by another bloc at any time.
+ *      The reference counter of the bloc is decreased and when it reaches 0 the bloc is marked as flushed:
+ *      the TileSet remains in VRAM but it can be overwritten by another bloc at any time.
  *
  *  \param cache
  *      Cache used for allocation.
@@ -197,6 +225,78 @@ void TC_free(TileCache *cache, TileSet *tileset);
  */
 s16 TC_getTileIndex(TileCache *cache, TileSet *tileset);
 
+/**
+ *  \brief
+ *      Change the VRAM region used by the specified Tile cache.<br/>
+ *      Flushable blocs which are outside the new region are released.
+ *
+ *  \param cache
+ *      Cache we want to move or resize.
+ *  \param startIndex
+ *      New tile start index in VRAM for the cache.
+ *  \param size
+ *      New size in tile of the cache.
+ *  \return
+ *      FALSE if a fixed (allocated) bloc does not fit in the new region, in which case nothing is changed.
+ */
+u16 TC_setRegion(TileCache *cache, u16 startIndex, u16 size);
+/**
+ *  \brief
+ *      Return the number of free tile in the specified Tile cache (tiles not used by an allocated TileSet).<br/>
+ *      Flushed blocs are considered as free space.
+ *
+ *  \param cache
+ *      Cache we want to retrieve the free tile number.
+ */
+u16 TC_getFreeTile(TileCache *cache);
+/**
+ *  \brief
+ *      Return the size (in tile) of the largest free contiguous region in the specified Tile cache.<br/>
+ *      That is the biggest TileSet which can be allocated without failing.
+ *
+ *  \param cache
+ *      Cache we want to retrieve the largest free region.
+ */
+u16 TC_getLargestFreeRegion(TileCache *cache);
+
+/**
+ *  \brief
+ *      Defragment the specified Tile cache by moving allocated (fixed) blocs down to the lowest free regions.<br/>
+ *      Blocs are moved with VRAM copy DMA and their VRAM index is updated so TC_alloc(..) and TC_reAlloc(..)
+ *      return the new index (the sprite engine picks it up on next SPR_update(..)).
+ *
+ *  \param cache
+ *      Cache to defragment.
+ *  \param maxTile
+ *      Maximum number of tile to move (VRAM copy is slow so keep it low if you call it during VBlank).
+ *  \return
+ *      number of tile moved (0 if nothing could be moved).
+ *
+ *  A moved bloc never overwrites a VRAM region released in the same pass so the currently displayed frame
+ *  (still using old indexes) stays correct.<br/>
+ *  Flushed blocs located in destination regions are evicted.<br/>
+ *  The method has to be called when no upload to the cache is pending in the DMA queue (ideally during VBlank).
+ */
+u16 TC_defrag(TileCache *cache, u16 maxTile);
+/**
+ *  \brief
+ *      Enable automatic defragmentation of the specified Tile cache.<br/>
+ *      When an allocation in the cache needed to evict flushed blocs or failed, the cache is incrementally
+ *      defragmented during the next VBlank(s) after the DMA queue has been flushed.<br/>
+ *      A new defragmentation pass only starts once the cache user refreshed all its indexes
+ *      (TC_flushCache(..), TC_alloc(..) / TC_reAlloc(..) then TC_endUpdate(..)) so the displayed frame never uses
+ *      a region overwritten by a moved bloc.<br/>
+ *      <b>Warning:</b> don't use it for a cache whose indexes are stored in tilemaps (or anywhere not refreshed on each
+ *      update) as moved blocs would leave them pointing to old (then overwritten) regions.
+ *
+ *  \param cache
+ *      Cache to automatically defragment (only one cache can use automatic defragmentation).<br/>
+ *      NULL to disable automatic defragmentation.
+ *  \param maxTilePerFrame
+ *      Maximum number of tile to move per frame (32 is a reasonable value).
+ */
+void TC_setAutoDefrag(TileCache *cache, u16 maxTilePerFrame);
+
 /**
  *  \brief
  *      Will upload the specified Tileset at given VRAM tile position during VBlank.
@@ -0,0 +1,125 @@
+/**
+ *  \file tile_loader.h
+ *  \brief Progressive TileSet loader
+ *
+ * This unit loads large TileSet in VRAM over several frames.<br/>
+ * VDP_loadTileSet(..) does the whole transfer at once so loading a large TileSet during game either
+ * blanks the screen or produces tearing. Here the transfer is split in chunks of a few tiles (see TL_setBudget(..))
+ * queued in the DMA queue at each VBlank, so the next area tiles can be prefetched while playing.<br/>
+ * A compressed TileSet is first unpacked in memory (at TL_load(..) call), the unpacked buffer is released
+ * when TL_isComplete(..) returns TRUE or when the load is cancelled.
+ */
+
+#ifndef _TILE_LOADER_H_
+#define _TILE_LOADER_H_
+
+#include "vdp.h"
+#include "vdp_tile.h"
+
+
+/**
+ *  \brief
+ *      Maximum number of progressive load pending at same time.
+ */
+#define TL_MAX_LOAD         4
+/**
+ *  \brief
+ *      Default number of tile sent per frame (2 KB of VRAM transfer).
+ */
+#define TL_DEFAULT_BUDGET   64
+
+
+/**
+ *  \brief
+ *      Progressive load structure.
+ *
+ *  \param tiles
+ *      Tile data we are transferring from (ROM data or unpacked buffer).
+ *  \param unpacked
+ *      Unpacked TileSet (if source TileSet was compressed).
+ *  \param index
+ *      VRAM destination tile index.
+ *  \param numTile
+ *      Number of tile to load.
+ *  \param done
+ *      Number of tile already queued for transfer.
+ *  \param queuePos
+ *      DMA queue size after the last chunk was queued (used to detect its transfer when DMA auto flush is disabled).
+ */
+typedef struct
+{
+    const u32 *tiles;
+    TileSet *unpacked;
+    u16 index;
+    u16 numTile;
+    vu16 done;
+    vu16 queuePos;
+} TileLoader;
+
+
+/**
+ *  \brief
+ *      Start a progressive TileSet load, transfer starts on next VBlank.
+ *
+ *  \param loader
+ *      Load structure to use (should stay valid until the load is complete).
+ *  \param tileset
+ *      TileSet to load (can be compressed).
+ *  \param index
+ *      VRAM tile index where to load the TileSet.
+ *  \return
+ *      FALSE if TL_MAX_LOAD loads are already pending or if the TileSet could not be unpacked (not enough memory).
+ *
+ *  Pending loads are processed in order.
+ */
+u16 TL_load(TileLoader *loader, const TileSet *tileset, u16 index);
+/**
+ *  \brief
+ *      Returns TRUE if the TileSet is completely loaded in VRAM (and release the unpacked buffer if any).
+ *
+ *  \param loader
+ *      Load structure.
+ *
+ *  When DMA auto flush is disabled (see DMA_setAutoFlush(..)), the load is only complete once the DMA queue
+ *  containing the last chunk has been flushed (the method can report it late if the queue is refilled
+ *  above that size before the call).
+ */
+u16 TL_isComplete(TileLoader *loader);
+/**
+ *  \brief
+ *      Returns the number of tile already loaded in VRAM.
+ *
+ *  \param loader
+ *      Load structure.
+ */
+u16 TL_getProgress(TileLoader *loader);
+/**
+ *  \brief
+ *      Cancel a progressive load (tiles already sent stay in VRAM).
+ *
+ *  \param loader
+ *      Load structure.
+ *
+ *  The unpacked buffer is released immediately so when DMA auto flush is disabled, flush the DMA queue
+ *  before cancelling a load.
+ */
+void TL_cancel(TileLoader *loader);
+
+/**
+ *  \brief
+ *      Returns the maximum number of tile sent per frame.
+ */
+u16 TL_getBudget();
+/**
+ *  \brief
+ *      Set the maximum number of tile sent per frame (shared by all pending loads).
+ *
+ *  \param numTile
+ *      Number of tile (default is TL_DEFAULT_BUDGET).<br/>
+ *      Keep in mind that DMA transfer in VBlank is limited to about 7 KB in NTSC (224 tiles)
+ *      and that it is shared with others VBlank transfers (sprites, scrolling...).
+ */
+void TL_setBudget(u16 numTile);
+
+
+#endif // _TILE_LOADER_H_
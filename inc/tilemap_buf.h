@@ -0,0 +1,194 @@
+/**
+ *  \file tilemap_buf.h
+ *  \brief Tilemap buffer (RAM shadow of a plan region)
+ *
+ * This unit provides a RAM copy of a rectangular plan region (HUD, destructible terrain...).<br/>
+ * Writes go to the RAM buffer first and only modified cells are marked as dirty, so rewriting the whole
+ * region each frame does not cost anything if only a few cells really changed.<br/>
+ * At VBlank the dirty cells of each row are sent as a minimal number of runs through the DMA queue
+ * (see dma.h file).
+ */
+
+#ifndef _TILEMAP_BUF_H_
+#define _TILEMAP_BUF_H_
+
+#include "vdp.h"
+#include "vdp_tile.h"
+
+
+/**
+ *  \brief
+ *      Maximum number of tilemap buffer which can be used at same time.
+ */
+#define TMB_MAX_BUFFER      4
+/**
+ *  \brief
+ *      Two runs of dirty cells separated by a gap of up to TMB_RUN_GAP clean cells are merged in a single DMA
+ *      (resending a few cells is cheaper than setting up a new DMA operation).
+ */
+#define TMB_RUN_GAP         3
+
+
+/**
+ *  \brief
+ *      Tilemap buffer structure.
+ *
+ *  \param plan
+ *      Plan VRAM address (APLAN, BPLAN or WINDOW).
+ *  \param x
+ *      Region X position in plan (in tile).
+ *  \param y
+ *      Region Y position in plan (in tile).
+ *  \param w
+ *      Region width (in tile).
+ *  \param h
+ *      Region height (in tile).
+ *  \param planWidth
+ *      Plan width (in tile).
+ *  \param maskWidth
+ *      Number of dirty mask word per row (one bit per cell).
+ *  \param dirty
+ *      At least one cell is dirty.
+ *  \param tilemap
+ *      RAM copy of the region (w * h tilemap entries, row ordered).
+ *  \param mask
+ *      Dirty cell masks (maskWidth * h words).
+ */
+typedef struct
+{
+    u16 plan;
+    u16 x;
+    u16 y;
+    u16 w;
+    u16 h;
+    u16 planWidth;
+    u16 maskWidth;
+    u16 dirty;
+    u16 *tilemap;
+    u16 *mask;
+} TileMapBuffer;
+
+
+/**
+ *  \brief
+ *      Initialize a tilemap buffer for the specified plan region.
+ *
+ *  \param buffer
+ *      Tilemap buffer to initialize.
+ *  \param plan
+ *      Plan where the region is located.<br/>
+ *      Accepted values are:<br/>
+ *      - APLAN<br/>
+ *      - BPLAN<br/>
+ *      - WINDOW<br/>
+ *  \param x
+ *      Region X position in plan (in tile).
+ *  \param y
+ *      Region Y position in plan (in tile).
+ *  \param w
+ *      Region width (in tile).
+ *  \param h
+ *      Region height (in tile).
+ *  \return
+ *      FALSE if the buffer could not be allocated (not enough memory or TMB_MAX_BUFFER already in use).
+ *
+ *  The buffer is cleared and fully marked as dirty so the region is cleared on next VBlank.
+ */
+u16 TMB_init(TileMapBuffer *buffer, u16 plan, u16 x, u16 y, u16 w, u16 h);
+/**
+ *  \brief
+ *      Release a tilemap buffer.
+ *
+ *  \param buffer
+ *      Tilemap buffer to release.
+ */
+void TMB_release(TileMapBuffer *buffer);
+
+/**
+ *  \brief
+ *      Set a tilemap entry in the buffer (cell is marked as dirty only if its value changed).
+ *
+ *  \param buffer
+ *      Tilemap buffer.
+ *  \param tile
+ *      Tilemap entry (see TILE_ATTR_FULL() macro).
+ *  \param x
+ *      X position in the region (in tile).
+ *  \param y
+ *      Y position in the region (in tile).
+ */
+void TMB_setTile(TileMapBuffer *buffer, u16 tile, u16 x, u16 y);
+/**
+ *  \brief
+ *      Fill a rectangle of the buffer with the specified tilemap entry (only modified cells are marked as dirty).
+ *
+ *  \param buffer
+ *      Tilemap buffer.
+ *  \param tile
+ *      Tilemap entry (see TILE_ATTR_FULL() macro).
+ *  \param x
+ *      Rectangle X position in the region (in tile).
+ *  \param y
+ *      Rectangle Y position in the region (in tile).
+ *  \param w
+ *      Rectangle width (in tile).
+ *  \param h
+ *      Rectangle height (in tile).
+ */
+void TMB_fillRect(TileMapBuffer *buffer, u16 tile, u16 x, u16 y, u16 w, u16 h);
+/**
+ *  \brief
+ *      Copy a rectangle of tilemap data in the buffer (only modified cells are marked as dirty).
+ *
+ *  \param buffer
+ *      Tilemap buffer.
+ *  \param data
+ *      Tilemap data.
+ *  \param basetile
+ *      Base index and flag for tile reference in tilemap (see TILE_ATTR_FULL() macro).
+ *  \param x
+ *      Rectangle X position in the region (in tile).
+ *  \param y
+ *      Rectangle Y position in the region (in tile).
+ *  \param w
+ *      Rectangle width (in tile).
+ *  \param h
+ *      Rectangle height (in tile).
+ *  \param wm
+ *      Source tilemap width (in tile).
+ *
+ *  Same as VDP_setTileMapDataRectEx(..) except that unchanged cells are not sent again.
+ */
+void TMB_setTileMapRect(TileMapBuffer *buffer, const u16 *data, u16 basetile, u16 x, u16 y, u16 w, u16 h, u16 wm);
+
+/**
+ *  \brief
+ *      Mark a rectangle of the buffer as dirty.
+ *
+ *  \param buffer
+ *      Tilemap buffer.
+ *  \param x
+ *      Rectangle X position in the region (in tile).
+ *  \param y
+ *      Rectangle Y position in the region (in tile).
+ *  \param w
+ *      Rectangle width (in tile).
+ *  \param h
+ *      Rectangle height (in tile).
+ *
+ *  Use it after modifying <i>buffer->tilemap</i> directly.
+ */
+void TMB_markDirty(TileMapBuffer *buffer, u16 x, u16 y, u16 w, u16 h);
+/**
+ *  \brief
+ *      Mark a whole row of the buffer as dirty.
+ *
+ *  \param buffer
+ *      Tilemap buffer.
+ *  \param y
+ *      Row in the region (in tile).
+ */
+void TMB_markRowDirty(TileMapBuffer *buffer, u16 y);
+
+
+#endif // _TILEMAP_BUF_H_
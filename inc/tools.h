@@ -40,6 +40,19 @@
  *      Use RLE compression scheme adapted for Map data.
  */
 #define COMPRESSION_MAP_RLE     4
+/**
+ *  \brief
+ *      Map data cut in blocks of MAP_BLOCK_SIZE x MAP_BLOCK_SIZE tiles, each bloc being independently
+ *      compressed with the RLE MAP compression scheme (Map only).<br/>
+ *      A single block can be unpacked with unpackMapBlock(..) so a large Map can stay compressed in ROM.
+ */
+#define COMPRESSION_MAP_BLOCK   5
+
+/**
+ *  \brief
+ *      Block size (in tile) for Map using COMPRESSION_MAP_BLOCK compression.
+ */
+#define MAP_BLOCK_SIZE          16
 
 
 /**
@@ -257,6 +270,23 @@ TileSet *unpackTileSet(const TileSet *src, TileSet *dest);
  *      <i>NULL</i> is returned if there is not enough memory to store the unpacked map.
  */
 Map *unpackMap(const Map *src, Map *dest);
+/**
+ *  \brief
+ *      Unpack a single block of the specified Map (Map should use COMPRESSION_MAP_BLOCK compression).
+ *
+ *  \param src
+ *      map we want to unpack a block from.
+ *  \param blockX
+ *      block X position (in block, not in tile).
+ *  \param blockY
+ *      block Y position (in block, not in tile).
+ *  \param dest
+ *      Destination buffer, should be large enough to receive (MAP_BLOCK_SIZE * MAP_BLOCK_SIZE) tilemap entries.<br/>
+ *      Entries outside Map bounds (right and bottom border blocks) are undefined.
+ *  \return
+ *      FALSE if the Map does not use COMPRESSION_MAP_BLOCK compression.
+ */
+u16 unpackMapBlock(const Map *src, u16 blockX, u16 blockY, u16 *dest);
 /**
  *  \brief
  *      Unpack the specified Image structure.
@@ -413,6 +413,66 @@ extern const VDPPlan PLAN_B;
  */
 extern const VDPPlan PLAN_A;
 
+/**
+ *  \brief
+ *      VRAM layout requirements, used by VDP_computeLayout(..)
+ *
+ *  \param planWidth
+ *      Plan width in tile (32, 64 or 128).
+ *  \param planHeight
+ *      Plan height in tile (32, 64 or 128), width * height should not exceed 4096.
+ *  \param window
+ *      Set to TRUE if window plan is used (otherwise no VRAM is reserved for it).
+ *  \param hscrollMode
+ *      Horizontal scrolling mode (HSCROLL_PLANE, HSCROLL_TILE or HSCROLL_LINE), plane mode only requires a few bytes.
+ */
+typedef struct
+{
+    u16 planWidth;
+    u16 planHeight;
+    u16 window;
+    u16 hscrollMode;
+} VDPLayoutConfig;
+
+/**
+ *  \brief
+ *      VRAM layout computed by VDP_computeLayout(..)
+ *
+ *  \param planWidth
+ *      Plan width in tile.
+ *  \param planHeight
+ *      Plan height in tile.
+ *  \param aplan
+ *      Plan A tilemap address.
+ *  \param bplan
+ *      Plan B tilemap address.
+ *  \param window
+ *      Window tilemap address (first table in VRAM, it marks the end of tile space).
+ *  \param hscrl
+ *      H scroll table address.
+ *  \param slist
+ *      Sprite list address.
+ *  \param numTile
+ *      Number of tile available for user (between TILE_USERINDEX and font tiles).
+ *  \param holeIndex
+ *      Tile index of the largest unused VRAM area located between tables (can be used for a tile cache).
+ *  \param holeSize
+ *      Size (in tile) of the largest unused VRAM area located between tables.
+ */
+typedef struct
+{
+    u16 planWidth;
+    u16 planHeight;
+    u16 aplan;
+    u16 bplan;
+    u16 window;
+    u16 hscrl;
+    u16 slist;
+    u16 numTile;
+    u16 holeIndex;
+    u16 holeSize;
+} VDPLayout;
+
 
 // used by define
 extern u16 window_adr;
@@ -460,6 +520,29 @@ u8   VDP_getReg(u16 reg);
  *      value to set.
  */
 void VDP_setReg(u16 reg, u8 value);
+/**
+ *  \brief
+ *      Queue a VDP register value write for next VBlank.
+ *
+ *  \param reg
+ *      Register number we want to set value.
+ *  \param value
+ *      value to set.
+ *
+ *  Registers are written at the beginning of next VBlank in a single batch: if the same register
+ *  is queued several times during the frame only the last value is written.<br/>
+ *  VDP_getReg(..) still returns the current register value until the queued value is written.
+ */
+void VDP_queueReg(u16 reg, u8 value);
+/**
+ *  \brief
+ *      Returns the number of VDP control port writes saved during the last frame.
+ *
+ *  VDP registers are cached so setting a register to the value it already contains (as VDP_setAutoInc(2)
+ *  does repeatedly in many methods) or queuing a register already queued does not access the VDP control port.<br/>
+ *  Note that registers written directly through the control port are not seen by the cache.
+ */
+u16  VDP_getRegWriteSaved();
 
 /**
  *  \brief
@@ -623,6 +706,11 @@ void VDP_setHInterrupt(u8 value);
  *      Enable or Disable Hilight / Shadow effect.
  */
 void VDP_setHilightShadow(u8 value);
+/**
+ *  \brief
+ *      Returns TRUE if Hilight / Shadow effect is enabled.
+ */
+u8   VDP_getHilightShadow();
 
 /**
  *  \brief
@@ -760,6 +848,36 @@ void VDP_setSpriteListAddress(u16 value);
  */
 void VDP_setHScrollTableAddress(u16 value);
 
+/**
+ *  \brief
+ *      Compute a packed VRAM layout for the given requirements.
+ *
+ *  \param config
+ *      Layout requirements (plan size and used features).
+ *  \param layout
+ *      Computed layout.
+ *  \return
+ *      FALSE if the requirements are not valid (unsupported plan size).
+ *
+ *  Tables are packed from the end of VRAM with their alignment constraint (which depends from current screen width)
+ *  so the tile space is as large as possible.<br/>
+ *  When the window plan is not used its address points on the first table so it doesn't use any VRAM.<br/>
+ *  The layout is only computed here, use VDP_setLayout(..) to apply it.
+ */
+u16 VDP_computeLayout(const VDPLayoutConfig *config, VDPLayout *layout);
+/**
+ *  \brief
+ *      Apply a VRAM layout computed with VDP_computeLayout(..)
+ *
+ *  \param layout
+ *      Layout to apply.
+ *
+ *  VRAM content is not moved: plans are cleared, sprites are reset and the font is reloaded at its new
+ *  location (TILE_FONTINDEX depends from the window address).<br/>
+ *  Should be called before initializing the VRAM manager, the tile cache or the sprite engine.
+ */
+void VDP_setLayout(const VDPLayout *layout);
+
 /**
  *  \brief
  *      Sets the scan mode of the display.
@@ -46,6 +46,83 @@ typedef struct
  */
 extern u16 curTileInd;
 
+/**
+ *  \brief
+ *      Size of horizontal scroll shadow table (number of entry per plan).
+ */
+#define VDP_SCROLL_H_TABLE_SIZE     240
+/**
+ *  \brief
+ *      Size of vertical scroll shadow table (number of entry per plan).
+ */
+#define VDP_SCROLL_V_TABLE_SIZE     20
+
+
+/**
+ *  \brief
+ *      Returns the horizontal scroll shadow table (in RAM) of the specified plan.<br/>
+ *      You can freely modify it then call VDP_queueHorizontalScrollTable(..) to send it to the VDP at next VBlank.<br/>
+ *      Table content depends from the horizontal scrolling mode:<br/>
+ *      - Plain: entry 0 only<br/>
+ *      - Tile: one entry per tile (screenHeight / 8 entries)<br/>
+ *      - Line: one entry per line (screenHeight entries)<br/>
+ *
+ *  \param plan
+ *      Plan we want to get the horizontal scroll table.<br/>
+ *      Accepted values are:<br/>
+ *      - PLAN_A<br/>
+ *      - PLAN_B<br/>
+ *  \return
+ *      Horizontal scroll table (VDP_SCROLL_H_TABLE_SIZE entries).
+ *
+ *  The other horizontal scroll methods keep this table synchronized.
+ */
+s16 *VDP_getHorizontalScrollTable(VDPPlan plan);
+/**
+ *  \brief
+ *      Returns the vertical scroll shadow table (in RAM) of the specified plan.<br/>
+ *      You can freely modify it then call VDP_queueVerticalScrollTable(..) to send it to the VDP at next VBlank.<br/>
+ *      Table content depends from the vertical scrolling mode:<br/>
+ *      - Plain: entry 0 only<br/>
+ *      - 2-Tiles: one entry per 16 pixels column (VDP_SCROLL_V_TABLE_SIZE entries)<br/>
+ *
+ *  \param plan
+ *      Plan we want to get the vertical scroll table.<br/>
+ *      Accepted values are:<br/>
+ *      - PLAN_A<br/>
+ *      - PLAN_B<br/>
+ *  \return
+ *      Vertical scroll table (VDP_SCROLL_V_TABLE_SIZE entries).
+ *
+ *  The other vertical scroll methods keep this table synchronized.
+ */
+s16 *VDP_getVerticalScrollTable(VDPPlan plan);
+/**
+ *  \brief
+ *      Send the horizontal scroll table of the specified plan to the VDP at next VBlank.<br/>
+ *      The table is sent with a single DMA operation through the DMA queue (see dma.h) using the auto increment
+ *      step of the current scrolling mode so calling it several time in the same frame doesn't cost more.
+ *
+ *  \param plan
+ *      Plan we want to update the horizontal scroll table.<br/>
+ *      Accepted values are:<br/>
+ *      - PLAN_A<br/>
+ *      - PLAN_B<br/>
+ */
+void VDP_queueHorizontalScrollTable(VDPPlan plan);
+/**
+ *  \brief
+ *      Send the vertical scroll table of the specified plan to the VDP at next VBlank.<br/>
+ *      The table is sent with a single DMA operation through the DMA queue (see dma.h).
+ *
+ *  \param plan
+ *      Plan we want to update the vertical scroll table.<br/>
+ *      Accepted values are:<br/>
+ *      - PLAN_A<br/>
+ *      - PLAN_B<br/>
+ */
+void VDP_queueVerticalScrollTable(VDPPlan plan);
+
 /**
  *  \brief
  *      Set plan horizontal scroll (plain scroll mode).<br/>
@@ -89,7 +166,9 @@ void VDP_setHorizontalScroll(VDPPlan plan, s16 value);
  *  \param len
  *      Number of tile to set.
  *  \param use_dma
- *      Use DMA flag (faster for large transfer).
+ *      Use DMA flag (faster for large transfer).<br/>
+ *      When set the values are only stored in the scroll shadow table which is sent through the DMA queue at next VBlank
+ *      (see VDP_queueHorizontalScrollTable(..) and VDP_queueVerticalScrollTable(..)).
  *
  *  \see VDP_setScrollingMode() function to change scroll mode.
  */
@@ -116,7 +195,9 @@ void VDP_setHorizontalScrollTile(VDPPlan plan, u16 tile, s16* values, u16 len, u
  *  \param len
  *      Number of line to set.
  *  \param use_dma
- *      Use DMA flag (faster for large transfer).
+ *      Use DMA flag (faster for large transfer).<br/>
+ *      When set the values are only stored in the scroll shadow table which is sent through the DMA queue at next VBlank
+ *      (see VDP_queueHorizontalScrollTable(..) and VDP_queueVerticalScrollTable(..)).
  *
  *  \see VDP_setScrollingMode()
  */
@@ -161,7 +242,9 @@ void VDP_setVerticalScroll(VDPPlan plan, s16 value);
  *  \param len
  *      Number of tile to set.
  *  \param use_dma
- *      Use DMA flag (faster for large transfer).
+ *      Use DMA flag (faster for large transfer).<br/>
+ *      When set the values are only stored in the scroll shadow table which is sent through the DMA queue at next VBlank
+ *      (see VDP_queueHorizontalScrollTable(..) and VDP_queueVerticalScrollTable(..)).
  *
  *  \see VDP_setScrollingMode()
  */
@@ -13,9 +13,9 @@
 #define _VDP_PAL_H_
 
 
-#define VDPPALETTE_REDSFT           9
+#define VDPPALETTE_REDSFT           1
 #define VDPPALETTE_GREENSFT         5
-#define VDPPALETTE_BLUESFT          1
+#define VDPPALETTE_BLUESFT          9
 
 #define VDPPALETTE_REDMASK          0x000E
 #define VDPPALETTE_GREENMASK        0x00E0
@@ -50,6 +50,27 @@ typedef struct
     u16 *data;
 } Palette;
 
+/**
+ *  \brief
+ *      Precomputed palette blend (see VDP_initBlend(..)).
+ *
+ *  \param index
+ *      First color index (0-63).
+ *  \param length
+ *      Number of color.
+ *  \param numLevel
+ *      Number of blend level (level 0 = source palette, level numLevel = destination palette).
+ *  \param data
+ *      Blended palettes ((numLevel + 1) * length colors).
+ */
+typedef struct
+{
+    u16 index;
+    u16 length;
+    u16 numLevel;
+    u16 *data;
+} PaletteBlend;
+
 
 /**
  *  \brief
@@ -145,7 +166,10 @@ void VDP_setPalette(u16 num, const u16 *pal);
 
 
 // these functions should be private as they are called by VDP_fadeXXX functions internally
-// but they can be useful sometime for better control on the fading processus
+// but they can be useful sometime for better control on the fading processus.
+// Intermediate fading frames are precomputed by VDP_initFading(..) in a fixed size buffer
+// (64 colors on 16 frames) so VDP_doStepFading(..) only has to send them, remaining frames
+// are computed on the fly.
 u16  VDP_doStepFading(u16 waitVSync);
 u16  VDP_initFading(u16 fromcol, u16 tocol, const u16 *palsrc, const u16 *paldst, u16 numframe, u16 waitVSync);
 
@@ -369,6 +393,100 @@ void VDP_fadeOutAll(u16 numframe, u8 async);
  */
 void VDP_fadeInAll(const u16 *pal, u16 numframe, u8 async);
 
+/**
+ *  \brief
+ *      Precompute blend between 2 palettes (cross fade).
+ *
+ *  \param blend
+ *      Blend structure to initialize.
+ *  \param index
+ *      Color index where the palette is loaded (0-63).
+ *  \param src
+ *      Source palette (level 0).
+ *  \param dst
+ *      Destination palette (level numLevel).
+ *  \param length
+ *      Number of color (index + length should not exceed 64).
+ *  \param numLevel
+ *      Number of blend level.
+ *  \return
+ *      FALSE if colors exceed CRAM or if there is not enough memory for the blend table ((numLevel + 1) * length * 2 bytes).
+ *
+ *  All blended palettes are computed here so changing blend level later doesn't cost any CPU.<br/>
+ *  When Hilight / Shadow mode is enabled, the shadow and highlight operator colors (62 and 63) are never blended.
+ */
+u16  VDP_initBlend(PaletteBlend *blend, u16 index, const u16 *src, const u16 *dst, u16 length, u16 numLevel);
+/**
+ *  \brief
+ *      Precompute blend of a palette toward a single color (fade to color or partial tint).
+ *
+ *  \param blend
+ *      Blend structure to initialize.
+ *  \param index
+ *      Color index where the palette is loaded (0-63).
+ *  \param src
+ *      Source palette (level 0).
+ *  \param color
+ *      Tint color.
+ *  \param strength
+ *      Tint strength at last level (256 = full color, 128 = half tint for night time effect...).
+ *  \param length
+ *      Number of color (index + length should not exceed 64).
+ *  \param numLevel
+ *      Number of blend level.
+ *  \return
+ *      FALSE if colors exceed CRAM or if there is not enough memory for the blend table.
+ */
+u16  VDP_initBlendToColor(PaletteBlend *blend, u16 index, const u16 *src, u16 color, u16 strength, u16 length, u16 numLevel);
+/**
+ *  \brief
+ *      Precompute blend of a palette toward its shadowed (or highlighted) intensities.
+ *
+ *  \param blend
+ *      Blend structure to initialize.
+ *  \param index
+ *      Color index where the palette is loaded (0-63).
+ *  \param src
+ *      Source palette (level 0).
+ *  \param highlight
+ *      FALSE to reach shadow intensity, TRUE to reach highlight intensity.
+ *  \param length
+ *      Number of color (index + length should not exceed 64).
+ *  \param numLevel
+ *      Number of blend level.
+ *  \return
+ *      FALSE if colors exceed CRAM or if there is not enough memory for the blend table.
+ *
+ *  Last level colors look like the source colors displayed in shadow (or highlight) mode so a plan
+ *  can be smoothly faded to match shadowed sprites / planes.
+ */
+u16  VDP_initBlendToShadow(PaletteBlend *blend, u16 index, const u16 *src, u16 highlight, u16 length, u16 numLevel);
+/**
+ *  \brief
+ *      Release memory used by a blend.
+ */
+void VDP_releaseBlend(PaletteBlend *blend);
+/**
+ *  \brief
+ *      Returns blended palette for the specified level.
+ *
+ *  \param blend
+ *      Blend.
+ *  \param level
+ *      Blend level (0 - numLevel).
+ */
+const u16* VDP_getBlendPalette(const PaletteBlend *blend, u16 level);
+/**
+ *  \brief
+ *      Set blend level, the blended palette is sent to CRAM on next VBlank through the DMA queue.
+ *
+ *  \param blend
+ *      Blend.
+ *  \param level
+ *      Blend level (0 - numLevel).
+ */
+void VDP_setBlendLevel(const PaletteBlend *blend, u16 level);
+
 /**
  *  \brief
  *      Returns TRUE if currently doing a asynchronous fade operation.
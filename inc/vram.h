@@ -0,0 +1,148 @@
+/**
+ *  \file vram.h
+ *  \brief VRAM tile space manager
+ *
+ * This unit provides a simple VRAM tile space manager.<br/>
+ * It shares a VRAM tile area between several Tile caches (sprites, backgrounds, fonts...)
+ * so each of them gets a budget instead of a hard coded VRAM region.<br/>
+ * Caches are placed in the managed area in creation order (first free region which fits).<br/>
+ * When a cache runs out of space (TC_alloc(..) fails to find a free region) it automatically tries
+ * to borrow VRAM from the unassigned space or from its neighbour caches (only if their border tiles are free).<br/>
+ * The sprite engine uses the VRAM manager for its cache when it has been initialized before SPR_init(..).
+ */
+
+#ifndef _VRAM_H_
+#define _VRAM_H_
+
+#include "tile_cache.h"
+
+
+/**
+ *  \brief
+ *      Maximum number of cache the VRAM manager can handle.
+ */
+#define VRAM_MAX_CACHE      8
+
+
+/**
+ *  \brief
+ *      Cache usage information.
+ *
+ *  \param size
+ *      Cache size (in tile).
+ *  \param free
+ *      Number of free tile in the cache (not used by an allocated TileSet).
+ *  \param largestFree
+ *      Size (in tile) of the largest free contiguous region in the cache.
+ *  \param fragmentation
+ *      Fragmentation of the cache free space in percent (0 = all free space is contiguous).
+ */
+typedef struct
+{
+    u16 size;
+    u16 free;
+    u16 largestFree;
+    u16 fragmentation;
+} VRAMCacheInfo;
+
+
+/**
+ *  \brief
+ *      Initialize the VRAM manager.
+ *
+ *  \param startIndex
+ *      Start tile index of the VRAM area to manage.
+ *  \param size
+ *      Size (in tile) of the VRAM area to manage.
+ *
+ *  By default you can use TILE_USERINDEX as start index and (TILE_FONTINDEX - TILE_USERINDEX) as size
+ *  to manage all user VRAM tile space.
+ */
+void VRAM_init(u16 startIndex, u16 size);
+/**
+ *  \brief
+ *      End the VRAM manager.<br/>
+ *      Caches previously created stay valid but they are not managed anymore.
+ */
+void VRAM_end();
+/**
+ *  \brief
+ *      Return TRUE if the VRAM manager is initialized.
+ */
+u16 VRAM_isInitialized();
+
+/**
+ *  \brief
+ *      Create and register a new Tile cache in the managed VRAM area.
+ *
+ *  \param cache
+ *      Tile cache to create.
+ *  \param size
+ *      Initial size (in tile) of the cache.
+ *  \return
+ *      FALSE if there is no free VRAM region large enough or no more cache slot.
+ *
+ *  See TC_createCache(..) method.
+ */
+u16 VRAM_createCache(TileCache *cache, u16 size);
+/**
+ *  \brief
+ *      Create and register a new Tile cache in the managed VRAM area.
+ *
+ *  \param cache
+ *      Tile cache to create.
+ *  \param size
+ *      Initial size (in tile) of the cache.
+ *  \param numBloc
+ *      Maximum number of bloc (tileset) the cache can handle.
+ *  \return
+ *      FALSE if there is no free VRAM region large enough or no more cache slot.
+ *
+ *  See TC_createCacheEx(..) method.
+ */
+u16 VRAM_createCacheEx(TileCache *cache, u16 size, u16 numBloc);
+/**
+ *  \brief
+ *      Release the specified Tile cache and give back its VRAM area to the VRAM manager.
+ *
+ *  \param cache
+ *      Tile cache to release.
+ */
+void VRAM_releaseCache(TileCache *cache);
+
+/**
+ *  \brief
+ *      Change the VRAM budget of the specified cache.
+ *
+ *  \param cache
+ *      Tile cache to resize.
+ *  \param size
+ *      New size (in tile) of the cache.
+ *  \return
+ *      FALSE if the operation failed (not enough free VRAM to grow or allocated TileSet in the released area).
+ *
+ *  When growing, free VRAM is taken from the unassigned space or from neighbour caches.<br/>
+ *  When shrinking, VRAM is released from the end of the cache.
+ */
+u16 VRAM_setCacheSize(TileCache *cache, u16 size);
+
+/**
+ *  \brief
+ *      Return the number of tile not assigned to any cache in the managed VRAM area.
+ */
+u16 VRAM_getFreeTile();
+/**
+ *  \brief
+ *      Retrieve usage information of the specified cache.
+ *
+ *  \param cache
+ *      Tile cache we want to get information from.
+ *  \param info
+ *      Destination information structure.
+ *
+ *  This method can consume a lot of time, use it for debugging or budget balancing only.
+ */
+void VRAM_getCacheInfo(TileCache *cache, VRAMCacheInfo *info);
+
+
+#endif // _VRAM_H_
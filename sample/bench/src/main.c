@@ -0,0 +1,256 @@
+#include "genesis.h"
+
+
+// number of loop for each benchmark
+#define BENCH_LOOP      100
+// CPU cycles per frame (NTSC)
+#define FRAME_CYCLES    127840
+
+// triangle benchmark type
+#define TRI_FLAT        0
+#define TRI_SHADED      1
+#define TRI_TEXTURED    2
+
+
+// forward
+static u32 benchParallax(Parallax *parallax);
+static u32 benchPolygon(u16 flags);
+static u32 benchLine(u16 flags);
+static u32 benchTriangle(u16 flags, u16 type);
+static void showResult(const char *name, u32 cycles, u16 y);
+static void showRate(const char *name, u32 cycles, u16 y);
+
+static ParallaxBand bands[224];
+
+// 32x32 4bpp texture
+static u8 texData[16 * 32];
+static const Bitmap texture = { COMPRESSION_NONE, 32, 32, NULL, texData };
+
+
+int main()
+{
+    Parallax parallax;
+    u32 cycles;
+    u32 bmpCycles[4];
+    u32 triCycles[5];
+    s16 camX;
+    u16 i;
+
+    VDP_setScreenWidth320();
+    VDP_setPaletteColor(15, 0x0EEE);
+
+    // bitmap fill rate, X doubled pixels then real X resolution
+    bmpCycles[0] = benchPolygon(0);
+    bmpCycles[1] = benchPolygon(BMP_FLAG_4BPP);
+    bmpCycles[2] = benchLine(0);
+    bmpCycles[3] = benchLine(BMP_FLAG_4BPP);
+
+    // texture pattern (diagonal stripes)
+    for(i = 0; i < sizeof(texData); i++)
+        texData[i] = ((((i >> 4) + (i << 1)) & 0xF) << 4) | (((i >> 4) + (i << 1) + 1) & 0xF);
+
+    // triangle rasterizers
+    triCycles[0] = benchTriangle(0, TRI_FLAT);
+    triCycles[1] = benchTriangle(0, TRI_SHADED);
+    triCycles[2] = benchTriangle(BMP_FLAG_4BPP, TRI_SHADED);
+    triCycles[3] = benchTriangle(0, TRI_TEXTURED);
+    triCycles[4] = benchTriangle(BMP_FLAG_4BPP, TRI_TEXTURED);
+
+    // restore plans for parallax
+    VDP_setPlanSize(64, 32);
+    VDP_setVerticalScroll(PLAN_A, 0);
+    VDP_clearPlan(APLAN, 1);
+    VDP_waitDMACompletion();
+
+    // fill plan B with some pattern so we can see the parallax effect
+    for(i = 0; i < 28; i++)
+        VDP_drawTextBG(BPLAN, "|....|....|....|....|....|....|....|....|....|....|....|....|...", TILE_ATTR(PAL0, FALSE, FALSE, FALSE), 0, i);
+
+    // one band per line, speed increasing from top to bottom
+    for(i = 0; i < 224; i++)
+    {
+        bands[i].height = 1;
+        bands[i].speed = FIX16(0.25) + ((i * FIX16(1.75)) / 224);
+    }
+
+    PARA_init(&parallax, PLAN_B, bands, 224);
+
+    VDP_drawText("SGDK benchmark", 1, 1);
+
+    cycles = benchParallax(&parallax);
+    showResult("Parallax 224 bands", cycles, 3);
+    showResult("BMP poly 64x64 x2", bmpCycles[0], 6);
+    showResult("BMP poly 64x64 4bpp", bmpCycles[1], 9);
+    showResult("BMP line 128 x2", bmpCycles[2], 12);
+    showResult("BMP line 128 4bpp", bmpCycles[3], 15);
+    showRate("Tri 32x32 flat x2", triCycles[0], 18);
+    showRate("Tri 32x32 gouraud x2", triCycles[1], 19);
+    showRate("Tri 32x32 gouraud 4bpp", triCycles[2], 20);
+    showRate("Tri 32x32 texture x2", triCycles[3], 21);
+    showRate("Tri 32x32 texture 4bpp", triCycles[4], 22);
+
+    camX = 0;
+    while(TRUE)
+    {
+        PARA_update(&parallax, camX);
+        camX += 2;
+
+        VDP_waitVSync();
+    }
+
+    return 0;
+}
+
+static u32 benchParallax(Parallax *parallax)
+{
+    u16 i;
+
+    startTimer(0);
+
+    for(i = 0; i < BENCH_LOOP; i++)
+        PARA_update(parallax, i);
+
+    // 1 subtick = 1/76800 s ~= 100 CPU cycles
+    return (getTimer(0, FALSE) * 100) / BENCH_LOOP;
+}
+
+// cycles to fill a 64x64 square (4096 pixels)
+static u32 benchPolygon(u16 flags)
+{
+    Vect2D_s16 pts[4];
+    u32 res;
+    u16 i;
+
+    BMP_initEx(flags, PAL0, FALSE, BMP_WIDTH, BMP_HEIGHT);
+
+    startTimer(0);
+
+    for(i = 0; i < BENCH_LOOP; i++)
+    {
+        const s16 x = i & 127;
+        const s16 y = i & 63;
+
+        pts[0].x = x;
+        pts[0].y = y;
+        pts[1].x = x + 63;
+        pts[1].y = y;
+        pts[2].x = x + 63;
+        pts[2].y = y + 63;
+        pts[3].x = x;
+        pts[3].y = y + 63;
+
+        BMP_drawPolygon(pts, 4, (flags & BMP_FLAG_4BPP)?(i & 15):((i & 15) * 0x11));
+    }
+
+    res = (getTimer(0, FALSE) * 100) / BENCH_LOOP;
+
+    BMP_end();
+
+    return res;
+}
+
+// cycles to draw a 128 pixels long line
+static u32 benchLine(u16 flags)
+{
+    Line line;
+    u32 res;
+    u16 i;
+
+    BMP_initEx(flags, PAL0, FALSE, BMP_WIDTH, BMP_HEIGHT);
+
+    startTimer(0);
+
+    for(i = 0; i < BENCH_LOOP; i++)
+    {
+        line.pt1.x = i & 127;
+        line.pt1.y = i & 31;
+        line.pt2.x = (i & 127) + 127;
+        line.pt2.y = (i & 31) + 100;
+        line.col = (flags & BMP_FLAG_4BPP)?(i & 15):((i & 15) * 0x11);
+
+        BMP_drawLine(&line);
+    }
+
+    res = (getTimer(0, FALSE) * 100) / BENCH_LOOP;
+
+    BMP_end();
+
+    return res;
+}
+
+// cycles to draw a 32x32 right triangle (~512 pixels)
+static u32 benchTriangle(u16 flags, u16 type)
+{
+    Vect2D_s16 pts[3];
+    Vect2D_s16 uvs[3];
+    u8 cols[3];
+    u32 res;
+    u16 i;
+
+    BMP_initEx(flags, PAL0, FALSE, BMP_WIDTH, BMP_HEIGHT);
+
+    uvs[0].x = 0;
+    uvs[0].y = 0;
+    uvs[1].x = 31;
+    uvs[1].y = 0;
+    uvs[2].x = 0;
+    uvs[2].y = 31;
+
+    startTimer(0);
+
+    for(i = 0; i < BENCH_LOOP; i++)
+    {
+        const s16 x = i & 127;
+        const s16 y = i & 63;
+
+        pts[0].x = x;
+        pts[0].y = y;
+        pts[1].x = x + 32;
+        pts[1].y = y;
+        pts[2].x = x;
+        pts[2].y = y + 32;
+
+        cols[0] = i & 15;
+        cols[1] = (i + 5) & 15;
+        cols[2] = (i + 10) & 15;
+
+        if (type == TRI_SHADED) BMP_drawTriangleShaded(pts, cols);
+        else if (type == TRI_TEXTURED) BMP_drawTriangleTextured(pts, uvs, &texture);
+        else BMP_drawPolygon(pts, 3, (i & 15) * 0x11);
+    }
+
+    res = (getTimer(0, FALSE) * 100) / BENCH_LOOP;
+
+    BMP_end();
+
+    return res;
+}
+
+static void showResult(const char *name, u32 cycles, u16 y)
+{
+    char str[16];
+
+    VDP_drawText(name, 1, y);
+
+    uintToStr(cycles, str, 1);
+    VDP_drawText(str, 24, y);
+    VDP_drawText("cycles", 31, y);
+
+    // percent of frame time
+    uintToStr((cycles * 100) / FRAME_CYCLES, str, 1);
+    VDP_drawText(str, 24, y + 1);
+    VDP_drawText("% frame", 31, y + 1);
+}
+
+static void showRate(const char *name, u32 cycles, u16 y)
+{
+    char str[16];
+
+    VDP_drawText(name, 1, y);
+
+    // polygons per second
+    if (cycles) uintToStr((FRAME_CYCLES * 60) / cycles, str, 1);
+    else strcpy(str, "-");
+    VDP_drawText(str, 24, y);
+    VDP_drawText("poly/s", 31, y);
+}
@@ -11,30 +11,66 @@
 #include "vdp_tile.h"
 #include "vdp_pal.h"
 #include "vdp_bg.h"
+#include "dma.h"
 
 #include "memory.h"
 #include "tools.h"
 #include "string.h"
 
 
-#define BMP_FLAG_DOUBLEBUFFER   (1 << 0)
-
 #define BMP_STAT_FLIPPING       (1 << 0)
 #define BMP_STAT_BLITTING       (1 << 1)
 #define BMP_STAT_FLIPWAITING    (1 << 2)
 
 #define HAS_DOUBLEBUFFER        (flag & BMP_FLAG_DOUBLEBUFFER)
+#define IS_TILEORDER            (flag & BMP_FLAG_TILEORDER)
+#define IS_DIRTYROWS            (flag & BMP_FLAG_DIRTYROWS)
+#define IS_4BPP                 (flag & BMP_FLAG_4BPP)
 
 #define READ_IS_FB0             (bmp_buffer_read == bmp_buffer_0)
 #define READ_IS_FB1             (bmp_buffer_read == bmp_buffer_1)
 #define WRITE_IS_FB0            (bmp_buffer_write == bmp_buffer_0)
 #define WRITE_IS_FB1            (bmp_buffer_write == bmp_buffer_1)
 
-#define GET_YOFFSET             ((HAS_DOUBLEBUFFER && READ_IS_FB1)?((BMP_PLANHEIGHT / 2) + 4):4)
+// bitmap position on screen (in tile)
+#define CELL_XOFFSET            (((screenWidth >> 3) - cellWidth) >> 1)
+#define CELL_YOFFSET            (((screenHeight >> 3) - cellHeight) >> 1)
+// top border height (in pixel)
+#define VBORDER                 (CELL_YOFFSET << 3)
+
+#define GET_YOFFSET             ((HAS_DOUBLEBUFFER && READ_IS_FB1)?((BMP_PLANHEIGHT / 2) + CELL_YOFFSET):CELL_YOFFSET)
 
 
+// CPU bandwidth (tile row per extended blank) for maximum bitmap size
 #define NTSC_TILES_BW           7
 #define PAL_TILES_BW            10
+// DMA bandwidth (tile row per extended blank) in tile order mode
+#define NTSC_TILES_DMA_BW       14
+#define PAL_TILES_DMA_BW        20
+
+// byte offset in tile order buffer for a X byte coordinate (Y part excluded)
+#define TILEX(xb)               ((((xb) >> 2) << 5) + ((xb) & 3))
+
+// mark tile row containing scanline y as modified
+#define MARK_ROW(y)             dirtyRows |= ((u32) 1) << ((y) >> BMP_YPIXPERTILE_SFT)
+#define ALL_ROWS                ((((u32) 1) << cellHeight) - 1)
+
+// fixed point precision of triangle attributes gradients computation (color, texture coordinates)
+#define ATTR_FRAC_BITS          12
+// maximum polygon width and height for tile order and shaded / textured fill (edges and gradients computation fit in 32 bits)
+#define POLY_MAX_EXTENT         0x3FFF
+
+// polygon fill mode (bmp_fill.mode), order is used by bmp_a.s span jump table
+#define FILL_FLAT               0
+#define FILL_SHADED             1
+#define FILL_TEXTURED           2
+#define FILL_SHADED_4BPP        3
+#define FILL_TEXTURED_4BPP      4
+
+// tag of a cleared tile row (same for both buffers)
+#define ROWTAG_CLEAR            0
+// tag of an unknown tile row (VRAM content not yet initialized)
+#define ROWTAG_UNKNOWN          0xFFFF
 
 
 // we don't want to share them
@@ -49,6 +85,9 @@ static u8 *bmp_buffer_1;
 u8 *bmp_buffer_read;
 u8 *bmp_buffer_write;
 
+u16 bmp_width;
+u16 bmp_height;
+
 // internals
 static u16 flag;
 static u16 pal;
@@ -56,29 +95,123 @@ static u16 prio;
 static u16 state;
 static u16 phase;
 
+// bitmap size (in tile)
+static u16 cellWidth;
+static u16 cellHeight;
+// number of tile row sent per blank (CPU and DMA blit)
+static u16 blitBW;
+static u16 blitDMABW;
+
+// 4x4 ordered dithering thresholds (16 bits fraction, same table in bmp_a.s)
+static const u16 dither4x4[16] =
+{
+     2048, 34816, 10240, 43008,
+    51200, 18432, 59392, 26624,
+    14336, 47104,  6144, 38912,
+    63488, 30720, 55296, 22528
+};
+
+// shaded and textured polygon fill, used by bmp_a.s so don't change fields order.
+// Attribute value at pixel (x, y) is org + (dadx * x) + (dady * y) in 16.16 fixed point:
+// color for shaded fill, texel byte offset in row (tu / 2, parity in bit 15) and texel row
+// offset (tv * pitch) for textured fill.
+typedef struct
+{
+    const u8 *texImage;
+    s32 org[2];
+    s32 dadx[2];
+    s32 dady[2];
+    u16 mode;
+    u16 texUMask;
+    u16 texVMask;
+} PolyFill;
+
+PolyFill bmp_fill;
+
+// texture row pitch (in byte) = 1 << texShift
+static u16 texShift;
+
+// tile rows modified in write buffer since last flip
+static u32 dirtyRows;
+// tile rows remaining to transfer for current blit
+static u32 blitRows;
+// content tag of each tile row (RAM buffers and VRAM buffers)
+static u16 bufferTags[2][BMP_CELLHEIGHT];
+static u16 vramTags[2][BMP_CELLHEIGHT];
+static u16 lastTag;
+
 
 // forward
 extern void clearBitmapBuffer(u8 *bmp_buffer);
+extern void drawLineLinear(Line *l);
+extern void drawLine4bppLinear(Line *l);
+extern u16 drawPolygonLinear(const Vect2D_s16 *pts, u16 num, u8 col);
 
 static void doFlip();
 static void flipBuffer();
+static void commitRows();
+static void renumberTags();
+static u32 getBlitRows();
+static void markRows(s16 y0, s16 y1);
 static void initTilemap(u16 num);
+static u16 getBandwidth(u16 bw);
 static u16 doBlit();
+static u16 doBlitDMA();
+static u16 getOffset(u16 x, u16 y);
+static void drawLineTile(Line *l);
+static void drawLine4bppTile(Line *l);
+static u16 drawPolygonTile(const Vect2D_s16 *pts, u16 num, u8 col);
+static void fillSpanTile(u8 *row, u16 xl, u16 xr, u8 col);
+static void fillSpanShadedTile(u8 *row, s16 xl, s16 xr, s16 y);
+static void fillSpanTexturedTile(u8 *row, s16 xl, s16 xr, s16 y);
+static s32 mulAttr(s32 a, u16 n);
+static s32 divAttr(s32 n, s32 d);
+static u16 drawTriangle(const Vect2D_s16 *pts, const s16 *attrs, u16 mode);
+static u16 setTexture(const Bitmap *texture);
 //static void drawLine(u16 offset, s16 dx, s16 dy, s16 step_x, s16 step_y, u8 col);
 
 
 void BMP_init(u16 double_buffer, u16 palette, u16 priority)
 {
-    flag = (double_buffer) ? BMP_FLAG_DOUBLEBUFFER : 0;
+    BMP_initEx((double_buffer) ? BMP_FLAG_DOUBLEBUFFER : 0, palette, priority, BMP_WIDTH, BMP_HEIGHT);
+}
+
+void BMP_initEx(u16 flags, u16 palette, u16 priority, u16 w, u16 h)
+{
+    flag = flags & (BMP_FLAG_DOUBLEBUFFER | BMP_FLAG_TILEORDER | BMP_FLAG_DIRTYROWS | BMP_FLAG_4BPP);
     pal = palette & 3;
     prio = priority & 1;
 
+    // size is tile aligned
+    w &= ~BMP_XPIXPERTILEMASK;
+    h &= ~BMP_YPIXPERTILEMASK;
+    if ((w == 0) || (w > BMP_WIDTH)) w = BMP_WIDTH;
+    if ((h == 0) || (h > BMP_HEIGHT)) h = BMP_HEIGHT;
+
+    bmp_width = w;
+    bmp_height = h;
+
     bmp_buffer_0 = NULL;
     bmp_buffer_1 = NULL;
 
     BMP_reset();
 }
 
+u16 BMP_getFlags()
+{
+    return flag;
+}
+
+u16 BMP_getWidth()
+{
+    return bmp_width;
+}
+
+u16 BMP_getHeight()
+{
+    return bmp_height;
+}
+
 void BMP_end()
 {
     // re enabled VDP if it was disabled because of extended blank
@@ -107,9 +240,12 @@ void BMP_reset()
     if (bmp_buffer_0) MEM_free(bmp_buffer_0);
     if (bmp_buffer_1) MEM_free(bmp_buffer_1);
 
+    cellWidth = bmp_width >> BMP_XPIXPERTILE_SFT;
+    cellHeight = bmp_height >> BMP_YPIXPERTILE_SFT;
+
     // tile map allocation
-    bmp_buffer_0 = MEM_alloc(BMP_PITCH * BMP_HEIGHT * sizeof(u8));
-    bmp_buffer_1 = MEM_alloc(BMP_PITCH * BMP_HEIGHT * sizeof(u8));
+    bmp_buffer_0 = MEM_alloc(BMP_PITCH * bmp_height * sizeof(u8));
+    bmp_buffer_1 = MEM_alloc(BMP_PITCH * bmp_height * sizeof(u8));
 
     // need 64x64 cells sized plan
     VDP_setPlanSize(BMP_PLANWIDTH, BMP_PLANHEIGHT);
@@ -121,6 +257,22 @@ void BMP_reset()
     state = 0;
     phase = 0;
 
+    // blit bandwidth depends on bitmap size
+    if (IS_PALSYSTEM)
+    {
+        blitBW = getBandwidth(PAL_TILES_BW);
+        blitDMABW = getBandwidth(PAL_TILES_DMA_BW);
+    }
+    else
+    {
+        blitBW = getBandwidth(NTSC_TILES_BW);
+        blitDMABW = getBandwidth(NTSC_TILES_DMA_BW);
+    }
+
+    // VRAM content is unknown
+    memset(vramTags, 0xFF, sizeof(vramTags));
+    dirtyRows = 0;
+
     // default
     bmp_buffer_read = bmp_buffer_0;
     bmp_buffer_write = bmp_buffer_1;
@@ -134,7 +286,7 @@ void BMP_reset()
     VDP_setVerticalScroll(BMP_PLAN_ENUM, 0);
 
     // prepare hint for extended blank on next frame
-    VDP_setHIntCounter(((screenHeight - BMP_HEIGHT) >> 1) - 1);
+    VDP_setHIntCounter(VBORDER - 1);
     // enabled bitmap Int processing
     HIntProcess |= PROCESS_BITMAP_TASK;
     VIntProcess |= PROCESS_BITMAP_TASK;
@@ -250,35 +402,47 @@ void BMP_showFPS(u16 float_display)
 void BMP_clear()
 {
     clearBitmapBuffer(bmp_buffer_write);
+
+    // all rows are cleared
+    memset(bufferTags[WRITE_IS_FB0?0:1], ROWTAG_CLEAR, sizeof(bufferTags[0]));
+    dirtyRows = 0;
+}
+
+void BMP_markDirty(u16 y, u16 h)
+{
+    if (h) markRows(y, y + (h - 1));
 }
 
 
 u8* BMP_getWritePointer(u16 x, u16 y)
 {
-    const u16 off = (y * BMP_PITCH) + (x >> 1);
-
     // return write address
-    return &bmp_buffer_write[off];
+    return &bmp_buffer_write[getOffset(x, y)];
 }
 
 u8* BMP_getReadPointer(u16 x, u16 y)
 {
-    const u16 off = (y * BMP_PITCH) + (x >> 1);
-
     // return read address
-    return &bmp_buffer_read[off];
+    return &bmp_buffer_read[getOffset(x, y)];
 }
 
 
 u8 BMP_getPixel(u16 x, u16 y)
 {
     // pixel in screen ?
-    if ((x < BMP_WIDTH) && (y < BMP_HEIGHT))
+    if ((x < bmp_width) && (y < bmp_height))
     {
-        const u16 off = (y * BMP_PITCH) + (x >> 1);
-
         // read pixel
-        return bmp_buffer_write[off];
+        const u8 v = bmp_buffer_write[getOffset(x, y)];
+
+        if (IS_4BPP)
+        {
+            // even pixel is in high nibble
+            if (x & 1) return v & 0xF;
+            return v >> 4;
+        }
+
+        return v;
     }
 
     return 0;
@@ -287,12 +451,12 @@ u8 BMP_getPixel(u16 x, u16 y)
 void BMP_setPixel(u16 x, u16 y, u8 col)
 {
     // pixel in screen ?
-    if ((x < BMP_WIDTH) && (y < BMP_HEIGHT))
+    if ((x < bmp_width) && (y < bmp_height))
     {
-        const u16 off = (y * BMP_PITCH) + (x >> 1);
-
         // write pixel
-        bmp_buffer_write[off] = col;
+        if (IS_4BPP) BMP_SETNIBBLE(&bmp_buffer_write[getOffset(x, y)], x, col & 0xF)
+        else bmp_buffer_write[getOffset(x, y)] = col;
+        MARK_ROW(y);
     }
 }
 
@@ -311,12 +475,12 @@ void BMP_setPixels_V2D(const Vect2D_u16 *crd, u8 col, u16 num)
         const u16 y = v->y;
 
         // pixel inside screen ?
-        if ((x < BMP_WIDTH) && (y < BMP_HEIGHT))
+        if ((x < bmp_width) && (y < bmp_height))
         {
-            const u16 off = (y * BMP_PITCH) + (x >> 1);
-
             // write pixel
-            bmp_buffer_write[off] = c;
+            if (IS_4BPP) BMP_SETNIBBLE(&bmp_buffer_write[getOffset(x, y)], x, c & 0xF)
+            else bmp_buffer_write[getOffset(x, y)] = c;
+            MARK_ROW(y);
         }
 
         // next pixel
@@ -338,12 +502,12 @@ void BMP_setPixels(const Pixel *pixels, u16 num)
         const u16 y = p->pt.y;
 
         // pixel inside screen ?
-        if ((x < BMP_WIDTH) && (y < BMP_HEIGHT))
+        if ((x < bmp_width) && (y < bmp_height))
         {
-            const u16 off = (y * BMP_PITCH) + (x >> 1);
-
             // write pixel
-            bmp_buffer_write[off] = p->col;
+            if (IS_4BPP) BMP_SETNIBBLE(&bmp_buffer_write[getOffset(x, y)], x, p->col & 0xF)
+            else bmp_buffer_write[getOffset(x, y)] = p->col;
+            MARK_ROW(y);
         }
 
         // next pixel
@@ -352,6 +516,118 @@ void BMP_setPixels(const Pixel *pixels, u16 num)
 }
 
 
+void BMP_drawLine(Line *l)
+{
+    if (l->pt1.y < l->pt2.y) markRows(l->pt1.y, l->pt2.y);
+    else markRows(l->pt2.y, l->pt1.y);
+
+    if (IS_4BPP)
+    {
+        if (IS_TILEORDER) drawLine4bppTile(l);
+        else drawLine4bppLinear(l);
+    }
+    else if (IS_TILEORDER) drawLineTile(l);
+    else drawLineLinear(l);
+}
+
+u16 BMP_drawPolygon(const Vect2D_s16 *pts, u16 num, u8 col)
+{
+    const Vect2D_s16 *pt;
+    s16 yMin, yMax;
+    u16 i;
+
+    // modified rows
+    pt = pts;
+    yMin = yMax = pt->y;
+    i = num;
+    while(--i)
+    {
+        pt++;
+
+        if (pt->y < yMin) yMin = pt->y;
+        else if (pt->y > yMax) yMax = pt->y;
+    }
+
+    markRows(yMin, yMax);
+
+    // fill routines are pixel accurate, we just need the same color for even and odd pixels
+    if (IS_4BPP)
+    {
+        col &= 0xF;
+        col |= col << 4;
+    }
+
+    if (IS_TILEORDER) return drawPolygonTile(pts, num, col);
+
+    return drawPolygonLinear(pts, num, col);
+}
+
+u16 BMP_drawTriangleShaded(const Vect2D_s16 *pts, const u8 *cols)
+{
+    s16 attrs[3];
+
+    attrs[0] = cols[0] & 0xF;
+    attrs[1] = cols[1] & 0xF;
+    attrs[2] = cols[2] & 0xF;
+
+    return drawTriangle(pts, attrs, FILL_SHADED);
+}
+
+u16 BMP_drawQuadShaded(const Vect2D_s16 *pts, const u8 *cols)
+{
+    Vect2D_s16 tpts[3];
+    u8 tcols[3];
+    u16 res;
+
+    res = BMP_drawTriangleShaded(pts, cols);
+
+    // second triangle (0,2,3)
+    tpts[0] = pts[0];
+    tpts[1] = pts[2];
+    tpts[2] = pts[3];
+    tcols[0] = cols[0];
+    tcols[1] = cols[2];
+    tcols[2] = cols[3];
+
+    return BMP_drawTriangleShaded(tpts, tcols) | res;
+}
+
+u16 BMP_drawTriangleTextured(const Vect2D_s16 *pts, const Vect2D_s16 *uvs, const Bitmap *texture)
+{
+    s16 attrs[6];
+
+    if (!setTexture(texture)) return 0;
+
+    attrs[0] = uvs[0].x;
+    attrs[1] = uvs[0].y;
+    attrs[2] = uvs[1].x;
+    attrs[3] = uvs[1].y;
+    attrs[4] = uvs[2].x;
+    attrs[5] = uvs[2].y;
+
+    return drawTriangle(pts, attrs, FILL_TEXTURED);
+}
+
+u16 BMP_drawQuadTextured(const Vect2D_s16 *pts, const Vect2D_s16 *uvs, const Bitmap *texture)
+{
+    Vect2D_s16 tpts[3];
+    Vect2D_s16 tuvs[3];
+    u16 res;
+
+    res = BMP_drawTriangleTextured(pts, uvs, texture);
+
+    // second triangle (0,2,3)
+    tpts[0] = pts[0];
+    tpts[1] = pts[2];
+    tpts[2] = pts[3];
+    tuvs[0] = uvs[0];
+    tuvs[1] = uvs[2];
+    tuvs[2] = uvs[3];
+
+    return BMP_drawTriangleTextured(tpts, tuvs, texture) | res;
+}
+
+
 
 //void BMP_drawLineFast(Line *l)
 //{
@@ -916,7 +1192,7 @@ void BMP_setPixels(const Pixel *pixels, u16 num)
 void BMP_drawBitmapData(const u8 *image, u16 x, u16 y, u16 w, u16 h, u32 pitch)
 {
     // pixel out screen ?
-    if ((x >= BMP_WIDTH) || (y >= BMP_HEIGHT))
+    if ((x >= bmp_width) || (y >= bmp_height))
         return;
 
     u16 adj_w, adj_h;
@@ -924,21 +1200,44 @@ void BMP_drawBitmapData(const u8 *image, u16 x, u16 y, u16 w, u16 h, u32 pitch)
     u8 *dst;
 
     // limit bitmap size if larger than bitmap screen
-    if ((w + x) > BMP_WIDTH) adj_w = (BMP_WIDTH - (w + x)) >> 1;
+    if ((w + x) > bmp_width) adj_w = (bmp_width - x) >> 1;
     else adj_w = w >> 1;
 
-    if ((h + y) > BMP_HEIGHT) adj_h = BMP_HEIGHT - (h + y);
+    if ((h + y) > bmp_height) adj_h = bmp_height - y;
     else adj_h = h;
 
+    BMP_markDirty(y, adj_h);
+
     // prepare source and destination
     src = image;
-    dst = BMP_getWritePointer(x, y);
 
-    while(adj_h--)
+    if (IS_TILEORDER)
     {
-        memcpy(dst, src, adj_w);
-        src += pitch;
-        dst += BMP_PITCH;
+        const u16 xb = x >> 1;
+        u16 yc = y;
+
+        while(adj_h--)
+        {
+            u8 *row = &bmp_buffer_write[BMP_TILEOFFSET(0, yc)];
+            u16 i;
+
+            for(i = 0; i < adj_w; i++)
+                row[TILEX(xb + i)] = src[i];
+
+            src += pitch;
+            yc++;
+        }
+    }
+    else
+    {
+        dst = BMP_getWritePointer(x, y);
+
+        while(adj_h--)
+        {
+            memcpy(dst, src, adj_w);
+            src += pitch;
+            dst += BMP_PITCH;
+        }
     }
 }
 
@@ -971,6 +1270,29 @@ u16 BMP_drawBitmap(const Bitmap *bitmap, u16 x, u16 y, u16 loadpal)
     return TRUE;
 }
 
+static u16 drawScaled(const u8 *image, u16 wb, u16 h, u16 x, u16 y, u16 dst_w, u16 dst_h)
+{
+    u8 *buf;
+
+    // linear buffer --> scale directly in it
+    if (!IS_TILEORDER)
+    {
+        BMP_scale(image, wb, h, wb, BMP_getWritePointer(x, y), dst_w >> 1, dst_h, BMP_PITCH);
+        BMP_markDirty(y, dst_h);
+        return TRUE;
+    }
+
+    // scale in a temporary linear buffer then convert to tile order
+    buf = MEM_alloc((dst_w >> 1) * dst_h);
+    if (buf == NULL) return FALSE;
+
+    BMP_scale(image, wb, h, wb, buf, dst_w >> 1, dst_h, dst_w >> 1);
+    BMP_drawBitmapData(buf, x, y, dst_w, dst_h, dst_w >> 1);
+    MEM_free(buf);
+
+    return TRUE;
+}
+
 u16 BMP_drawBitmapScaled(const Bitmap *bitmap, u16 x, u16 y, u16 w, u16 h, u16 loadpal)
 {
     u16 bmp_wb, bmp_h;
@@ -988,11 +1310,15 @@ u16 BMP_drawBitmapScaled(const Bitmap *bitmap, u16 x, u16 y, u16 w, u16 h, u16 l
 
         if (b == NULL) return FALSE;
 
-        BMP_scale(b->image, bmp_wb, bmp_h, bmp_wb, BMP_getWritePointer(x, y), w >> 1, h, BMP_PITCH);
+        if (!drawScaled(b->image, bmp_wb, bmp_h, x, y, w, h))
+        {
+            MEM_free(b);
+            return FALSE;
+        }
+
         MEM_free(b);
     }
-    else
-        BMP_scale(bitmap->image, bmp_wb, bmp_h, bmp_wb, BMP_getWritePointer(x, y), w >> 1, h, BMP_PITCH);
+    else if (!drawScaled(bitmap->image, bmp_wb, bmp_h, x, y, w, h)) return FALSE;
 
     // load the palette
     if (loadpal) VDP_setPaletteColors((pal << 4) + (palette->index & 0xF), palette->data, palette->length);
@@ -1088,13 +1414,12 @@ u16 BMP_doHBlankProcess()
     if (phase == 0)
     {
         const u16 vcnt = GET_VCOUNTER;
-        const u16 scrh = screenHeight;
-        const u16 vborder = (scrh - BMP_HEIGHT) >> 1;
+        const u16 vborder = VBORDER;
 
         // enable VDP
         VDP_setEnable(1);
         // prepare hint to disable VDP and doing blit process
-        VDP_setHIntCounter((scrh - vborder) - (VDP_getHIntCounter() + vcnt + 3));
+        VDP_setHIntCounter((vborder + bmp_height) - (VDP_getHIntCounter() + vcnt + 3));
         // update phase
         phase = 1;
     }
@@ -1109,7 +1434,7 @@ u16 BMP_doHBlankProcess()
         // disable VDP
         VDP_setEnable(0);
         // prepare hint to re enable VDP
-        VDP_setHIntCounter(((screenHeight - BMP_HEIGHT) >> 1) - 1);
+        VDP_setHIntCounter(VBORDER - 1);
         // update phase
         phase = 3;
 
@@ -1135,7 +1460,7 @@ static void initTilemap(u16 num)
     VDP_setAutoInc(2);
 
     // calculated
-    const u32 offset = BMP_FBTILEMAP_OFFSET;
+    const u32 offset = ((BMP_PLANWIDTH * CELL_YOFFSET) + CELL_XOFFSET) * 2;
 
     if (num == 0)
     {
@@ -1152,7 +1477,7 @@ static void initTilemap(u16 num)
     plctrl = (u32 *) GFX_CTRL_PORT;
     pwdata = (u16 *) GFX_DATA_PORT;
 
-    i = BMP_CELLHEIGHT;
+    i = cellHeight;
 
     while(i--)
     {
@@ -1160,26 +1485,29 @@ static void initTilemap(u16 num)
         *plctrl = GFX_WRITE_VRAM_ADDR(addr_tilemap);
 
         // write tilemap line to VDP
-        j = BMP_CELLWIDTH >> 3;
+        j = cellWidth;
 
-        while(j--)
-        {
-            *pwdata = tile_ind++;
-            *pwdata = tile_ind++;
-            *pwdata = tile_ind++;
-            *pwdata = tile_ind++;
-            *pwdata = tile_ind++;
-            *pwdata = tile_ind++;
-            *pwdata = tile_ind++;
-            *pwdata = tile_ind++;
-        }
+        while(j--) *pwdata = tile_ind++;
 
+        // tile rows always use BMP_CELLWIDTH tiles in VRAM
+        tile_ind += BMP_CELLWIDTH - cellWidth;
         addr_tilemap += BMP_PLANWIDTH * 2;
     }
 }
 
+static u16 getBandwidth(u16 bw)
+{
+    const u32 lines = IS_PALSYSTEM?312:262;
+
+    // bandwidth is given for maximum bitmap size --> scale it with blank duration and tile row size
+    return (bw * BMP_CELLWIDTH * (lines - bmp_height)) / ((lines - BMP_HEIGHT) * cellWidth);
+}
+
 static void flipBuffer()
 {
+    // write buffer becomes read buffer --> tag its modified rows first
+    commitRows();
+
     if (READ_IS_FB0)
     {
         bmp_buffer_read = bmp_buffer_1;
@@ -1192,13 +1520,86 @@ static void flipBuffer()
     }
 }
 
+static void commitRows()
+{
+    u16 *tags = bufferTags[WRITE_IS_FB0?0:1];
+    u32 rows = dirtyRows;
+
+    while(rows)
+    {
+        // new content --> new tag
+        if (rows & 1)
+        {
+            if (++lastTag == ROWTAG_UNKNOWN) renumberTags();
+            *tags = lastTag;
+        }
+
+        tags++;
+        rows >>= 1;
+    }
+
+    dirtyRows = 0;
+}
+
+static void renumberTags()
+{
+    u16 *tags = bufferTags[0];
+    u16 i = 2 * BMP_CELLHEIGHT;
+
+    // tag counter wrapped: old tags could match new ones so renumber rows in use from start
+    // (no blit is running when rows are committed so it's safe to do it here)
+    lastTag = ROWTAG_CLEAR;
+    while(i--)
+    {
+        if (*tags != ROWTAG_CLEAR) *tags = ++lastTag;
+        tags++;
+    }
+    lastTag++;
+
+    // VRAM tags refer to old numbering --> send everything again
+    memset(vramTags, 0xFF, sizeof(vramTags));
+}
+
+static u32 getBlitRows()
+{
+    // send everything
+    if (!IS_DIRTYROWS) return ALL_ROWS;
+
+    const u16 *src = bufferTags[READ_IS_FB0?0:1];
+    u16 *dst = vramTags[(HAS_DOUBLEBUFFER && READ_IS_FB1)?1:0];
+    u32 rows = 0;
+    u16 i;
+
+    // only send rows which differ from VRAM content (and consider them as sent)
+    for(i = 0; i < cellHeight; i++)
+    {
+        if (src[i] != dst[i])
+        {
+            rows |= ((u32) 1) << i;
+            dst[i] = src[i];
+        }
+    }
+
+    return rows;
+}
+
+static void markRows(s16 y0, s16 y1)
+{
+    // clip to bitmap area
+    if (y0 < 0) y0 = 0;
+    if (y1 >= (s16) bmp_height) y1 = bmp_height - 1;
+    if (y0 > y1) return;
+
+    dirtyRows |= (((u32) 2) << (y1 >> BMP_YPIXPERTILE_SFT)) - (((u32) 1) << (y0 >> BMP_YPIXPERTILE_SFT));
+}
+
 static void doFlip()
 {
     // wait for DMA completion if used otherwise VDP writes can be corrupted
     VDP_waitDMACompletion();
 
     // copy tile buffer to VRAM
-    if (doBlit())
+    if (IS_TILEORDER?doBlitDMA():doBlit())
     {
         if (HAS_DOUBLEBUFFER)
         {
@@ -1258,80 +1659,688 @@ static u16 doBlit()
     vu32 *pldata;
     u32 *src;
     u32 addr_tile;
-    u16 i;
+    u16 i, j;
 
     VDP_setAutoInc(2);
 
-    src = (u32 *) bmp_buffer_read;
-
     if (HAS_DOUBLEBUFFER && READ_IS_FB1)
         addr_tile = BMP_FB1TILE;
     else
         addr_tile = BMP_FB0TILE;
 
+    // start blit
+    if (!(state & BMP_STAT_BLITTING))
+    {
+        state |= BMP_STAT_BLITTING;
+        blitRows = getBlitRows();
+        pos_i = 0;
+    }
+
+    i = blitBW;
+
     /* point to vdp ctrl port */
     plctrl = (u32 *) GFX_CTRL_PORT;
+    /* point to vdp data port */
+    pldata = (u32 *) GFX_DATA_PORT;
 
-    // previous blit not completed ?
-    if (state & BMP_STAT_BLITTING)
+    while(blitRows && i)
     {
-        // adjust tile address
-        addr_tile += pos_i * BMP_CELLWIDTH * 32;
-        // adjust src pointer
-        src += pos_i * (BMP_YPIXPERTILE * (BMP_PITCH / 4));
+        // tile row to send ?
+        if (blitRows & 1)
+        {
+            src = (u32 *) (bmp_buffer_read + (pos_i * (BMP_YPIXPERTILE * BMP_PITCH)));
+
+            // set destination address for tile
+            *plctrl = GFX_WRITE_VRAM_ADDR(addr_tile + (pos_i * (BMP_CELLWIDTH * 32)));
 
-        // set destination address for tile
-        *plctrl = GFX_WRITE_VRAM_ADDR(addr_tile);
+            // send it to VRAM
+            j = cellWidth;
+            while(j >= 8)
+            {
+                TRANSFER8(0)
+                src += 8;
+                j -= 8;
+            }
+            while(j--)
+            {
+                TRANSFER(0)
+                src++;
+            }
+
+            i--;
+        }
+
+        // next tile row
+        blitRows >>= 1;
+        pos_i++;
     }
+
+    // blit not yet done
+    if (blitRows) return 0;
+
+    // blit done
+    state &= ~BMP_STAT_BLITTING;
+
+    return 1;
+}
+
+static u16 doBlitDMA()
+{
+    static u16 pos_i;
+    u32 addr_tile;
+    u16 i;
+
+    if (HAS_DOUBLEBUFFER && READ_IS_FB1)
+        addr_tile = BMP_FB1TILE;
     else
+        addr_tile = BMP_FB0TILE;
+
+    // start blit
+    if (!(state & BMP_STAT_BLITTING))
     {
-        // start blit
         state |= BMP_STAT_BLITTING;
+        blitRows = getBlitRows();
         pos_i = 0;
+    }
+
+    i = blitDMABW;
+
+    while(blitRows && i)
+    {
+        // tile row to send ?
+        if (blitRows & 1)
+        {
+            const u16 start = pos_i;
+
+            // buffer is in tile order --> contiguous tile rows are sent with a single DMA (only for full width bitmap)
+            do
+            {
+                blitRows >>= 1;
+                pos_i++;
+                i--;
+            } while((blitRows & 1) && i && (cellWidth == BMP_CELLWIDTH));
+
+            DMA_doDma(DMA_VRAM, (u32) (bmp_buffer_read + (start * (BMP_CELLWIDTH * 32))), addr_tile + (start * (BMP_CELLWIDTH * 32)), (pos_i - start) * (cellWidth * 16), 2);
+        }
+        else
+        {
+            // next tile row
+            blitRows >>= 1;
+            pos_i++;
+        }
+    }
+
+    // blit not yet done
+    if (blitRows) return 0;
+
+    // blit done
+    state &= ~BMP_STAT_BLITTING;
+
+    return 1;
+}
+
+static u16 getOffset(u16 x, u16 y)
+{
+    if (IS_TILEORDER) return BMP_TILEOFFSET(x >> 1, y);
+
+    return (y * BMP_PITCH) + (x >> 1);
+}
+
+static void drawLineTile(Line *l)
+{
+    Line line = *l;
+
+    // process clipping (exit if outside screen)
+    if (BMP_clipLine(&line))
+    {
+        const u8 col = line.col;
+        s16 x = line.pt1.x >> 1;
+        s16 y = line.pt1.y;
+        s16 dx = (line.pt2.x >> 1) - x;
+        s16 dy = line.pt2.y - y;
+        s16 stepx, stepy;
+        s16 delta;
+        s16 cnt;
+
+        if (dx < 0)
+        {
+            dx = -dx;
+            stepx = -1;
+        }
+        else stepx = 1;
+
+        if (dy < 0)
+        {
+            dy = -dy;
+            stepy = -1;
+        }
+        else stepy = 1;
+
+        if (dx >= dy)
+        {
+            delta = dx >> 1;
+            cnt = dx + 1;
+
+            while(cnt--)
+            {
+                bmp_buffer_write[BMP_TILEOFFSET(x, y)] = col;
+
+                x += stepx;
+                if ((delta -= dy) < 0)
+                {
+                    y += stepy;
+                    delta += dx;
+                }
+            }
+        }
+        else
+        {
+            delta = dy >> 1;
+            cnt = dy + 1;
 
-        // set destination address for tile
-        *plctrl = GFX_WRITE_VRAM_ADDR(addr_tile);
+            while(cnt--)
+            {
+                bmp_buffer_write[BMP_TILEOFFSET(x, y)] = col;
+
+                y += stepy;
+                if ((delta -= dx) < 0)
+                {
+                    x += stepx;
+                    delta += dy;
+                }
+            }
+        }
     }
+}
 
-    const u16 remain = BMP_CELLHEIGHT - pos_i;
+static void drawLine4bppTile(Line *l)
+{
+    Line line = *l;
 
-    if (IS_PALSYSTEM)
+    // process clipping (exit if outside screen)
+    if (BMP_clipLine(&line))
     {
-        if (remain < PAL_TILES_BW) i = remain;
-        else i = PAL_TILES_BW;
+        const u8 col = line.col & 0xF;
+        s16 x = line.pt1.x;
+        s16 y = line.pt1.y;
+        s16 dx = line.pt2.x - x;
+        s16 dy = line.pt2.y - y;
+        s16 stepx, stepy;
+        s16 delta;
+        s16 cnt;
+
+        if (dx < 0)
+        {
+            dx = -dx;
+            stepx = -1;
+        }
+        else stepx = 1;
+
+        if (dy < 0)
+        {
+            dy = -dy;
+            stepy = -1;
+        }
+        else stepy = 1;
+
+        if (dx >= dy)
+        {
+            delta = dx >> 1;
+            cnt = dx + 1;
+
+            while(cnt--)
+            {
+                BMP_SETNIBBLE(&bmp_buffer_write[BMP_TILEOFFSET(x >> 1, y)], x, col)
+
+                x += stepx;
+                if ((delta -= dy) < 0)
+                {
+                    y += stepy;
+                    delta += dx;
+                }
+            }
+        }
+        else
+        {
+            delta = dy >> 1;
+            cnt = dy + 1;
+
+            while(cnt--)
+            {
+                BMP_SETNIBBLE(&bmp_buffer_write[BMP_TILEOFFSET(x >> 1, y)], x, col)
+
+                y += stepy;
+                if ((delta -= dx) < 0)
+                {
+                    x += stepx;
+                    delta += dy;
+                }
+            }
+        }
     }
-    else
+}
+
+static u16 drawPolygonTile(const Vect2D_s16 *pts, u16 num, u8 col)
+{
+    s16 leftEdge[BMP_HEIGHT];
+    s16 rightEdge[BMP_HEIGHT];
+    const Vect2D_s16 *pt;
+    s16 xMin, xMax, yMin, yMax;
+    u8 colEven, colOdd;
+    u16 i;
+    s16 y;
+
+    // find bounding box
+    pt = pts;
+    xMin = xMax = pt->x;
+    yMin = yMax = pt->y;
+    for(i = 1; i < num; i++)
     {
-        if (remain < NTSC_TILES_BW) i = remain;
-        else i = NTSC_TILES_BW;
+        pt++;
+
+        if (pt->x < xMin) xMin = pt->x;
+        else if (pt->x > xMax) xMax = pt->x;
+        if (pt->y < yMin) yMin = pt->y;
+        else if (pt->y > yMax) yMax = pt->y;
     }
 
-    // save position
-    pos_i += i;
+    // outside screen ?
+    if ((yMax < 0) || (xMax < 0) || (yMin >= (s16) bmp_height) || (xMin >= (s16) bmp_width)) return 0;
+    // too large (edge step would overflow)
+    if ((((s32) xMax - xMin) > POLY_MAX_EXTENT) || (((s32) yMax - yMin) > POLY_MAX_EXTENT)) return 0;
 
-    /* point to vdp data port */
-    pldata = (u32 *) GFX_DATA_PORT;
+    if (yMin < 0) yMin = 0;
+    if (yMax >= (s16) bmp_height) yMax = bmp_height - 1;
 
-    while(i--)
+    for(y = yMin; y <= yMax; y++)
+    {
+        leftEdge[y] = BMP_WIDTH;
+        rightEdge[y] = -1;
+    }
+
+    // scan convert all edges
+    pt = pts;
+    for(i = 0; i < num; i++)
     {
-        // send it to VRAM
-        TRANSFER8(0)
-        TRANSFER8(1)
-        TRANSFER8(2)
-        TRANSFER8(3)
+        const Vect2D_s16 *p0 = pt;
+        const Vect2D_s16 *p1 = (i == (num - 1))?pts:(pt + 1);
+        s16 x0, y0, x1, y1;
+
+        pt++;
+
+        if (p0->y <= p1->y)
+        {
+            x0 = p0->x;
+            y0 = p0->y;
+            x1 = p1->x;
+            y1 = p1->y;
+        }
+        else
+        {
+            x0 = p1->x;
+            y0 = p1->y;
+            x1 = p0->x;
+            y1 = p0->y;
+        }
+
+        // edge outside vertical range
+        if ((y1 < yMin) || (y0 > yMax)) continue;
+
+        {
+            const s32 step = (y1 != y0)?((((s32) (x1 - x0)) << 16) / (y1 - y0)):0;
+            const s16 ys = (y0 < yMin)?yMin:y0;
+            const s16 ye = (y1 > yMax)?yMax:y1;
+            s32 x = (((s32) x0) << 16) + (step * (ys - y0)) + 0x8000;
+
+            for(y = ys; y <= ye; y++)
+            {
+                const s16 xi = x >> 16;
+
+                if (xi < leftEdge[y]) leftEdge[y] = xi;
+                if (xi > rightEdge[y]) rightEdge[y] = xi;
 
-        src += (8 * BMP_PITCH) / 4;
+                x += step;
+            }
+
+            // horizontal edge
+            if (y1 == y0)
+            {
+                if (x1 < leftEdge[y0]) leftEdge[y0] = x1;
+                if (x1 > rightEdge[y0]) rightEdge[y0] = x1;
+            }
+        }
     }
 
-    // blit not yet done
-    if (pos_i < BMP_CELLHEIGHT) return 0;
+    // color nibbles are exchanged on even lines (same as linear mode)
+    colOdd = col;
+    colEven = (col << 4) | (col >> 4);
 
-    // blit done
-    state &= ~BMP_STAT_BLITTING;
+    for(y = yMin; y <= yMax; y++)
+    {
+        s16 xl = leftEdge[y];
+        s16 xr = rightEdge[y];
+
+        if (xl < 0) xl = 0;
+        if (xr >= (s16) bmp_width) xr = bmp_width - 1;
+
+        if (xr >= xl)
+        {
+            u8 *row = &bmp_buffer_write[BMP_TILEOFFSET(0, y)];
+
+            switch(bmp_fill.mode)
+            {
+                case FILL_FLAT:
+                    fillSpanTile(row, xl, xr, (y & 1)?colOdd:colEven);
+                    break;
+
+                case FILL_SHADED:
+                case FILL_SHADED_4BPP:
+                    fillSpanShadedTile(row, xl, xr, y);
+                    break;
+
+                default:
+                    fillSpanTexturedTile(row, xl, xr, y);
+                    break;
+            }
+        }
+    }
 
     return 1;
 }
 
+static void fillSpanTile(u8 *row, u16 xl, u16 xr, u8 col)
+{
+    u16 bl, br;
+
+    // left pixel is the low nibble of its byte
+    if (xl & 1)
+    {
+        u8 *dst = &row[TILEX(xl >> 1)];
+
+        *dst = (*dst & 0xF0) | (col & 0x0F);
+        xl++;
+    }
+    // right pixel is the high nibble of its byte
+    if (!(xr & 1))
+    {
+        u8 *dst = &row[TILEX(xr >> 1)];
+
+        *dst = (*dst & 0x0F) | (col & 0xF0);
+        if (xr == 0) return;
+        xr--;
+    }
+
+    if (xr < xl) return;
+
+    bl = xl >> 1;
+    br = xr >> 1;
+
+    // align to tile line
+    while((bl & 3) && (bl <= br))
+    {
+        row[TILEX(bl)] = col;
+        bl++;
+    }
+
+    // complete tile lines (8 pixels)
+    if ((bl + 3) <= br)
+    {
+        const u32 col32 = col * 0x01010101;
+        u32 *dst = (u32 *) &row[TILEX(bl)];
+
+        while((bl + 3) <= br)
+        {
+            *dst = col32;
+            dst += 32 / 4;
+            bl += 4;
+        }
+    }
+
+    while(bl <= br)
+    {
+        row[TILEX(bl)] = col;
+        bl++;
+    }
+}
+
+static u16 setTexture(const Bitmap *texture)
+{
+    u16 w;
+
+    // need raw data
+    if (texture->compression != COMPRESSION_NONE) return FALSE;
+    // texel offset should fit in 16 bits (signed)
+    if (((u32) (texture->w >> 1) * texture->h) > 32768) return FALSE;
+
+    // texture row pitch (in byte) = 1 << texShift
+    w = texture->w >> 1;
+    texShift = 0;
+    while(w > 1)
+    {
+        w >>= 1;
+        texShift++;
+    }
+
+    bmp_fill.texImage = texture->image;
+    bmp_fill.texUMask = (texture->w >> 1) - 1;
+    bmp_fill.texVMask = (texture->h - 1) << texShift;
+
+    return TRUE;
+}
+
+static u16 drawTriangle(const Vect2D_s16 *pts, const s16 *attrs, u16 mode)
+{
+    Vect2D_s16 tpts[3];
+    const u16 numAttr = (mode == FILL_TEXTURED)?2:1;
+    const s16 *a0, *a1, *a2;
+    s32 cross;
+    s32 ex1, ey1, ex2, ey2;
+    s16 xMin, xMax, yMin, yMax;
+    u16 res;
+    u16 i;
+
+    // bounding box
+    xMin = xMax = pts[0].x;
+    yMin = yMax = pts[0].y;
+    for(i = 1; i < 3; i++)
+    {
+        if (pts[i].x < xMin) xMin = pts[i].x;
+        else if (pts[i].x > xMax) xMax = pts[i].x;
+        if (pts[i].y < yMin) yMin = pts[i].y;
+        else if (pts[i].y > yMax) yMax = pts[i].y;
+    }
+
+    // too large (cross product and gradients would overflow)
+    if ((((s32) xMax - xMin) > POLY_MAX_EXTENT) || (((s32) yMax - yMin) > POLY_MAX_EXTENT)) return 0;
+
+    ex1 = pts[1].x - pts[0].x;
+    ey1 = pts[1].y - pts[0].y;
+    ex2 = pts[2].x - pts[0].x;
+    ey2 = pts[2].y - pts[0].y;
+
+    // empty triangle ?
+    cross = (ex1 * ey2) - (ex2 * ey1);
+    if (cross == 0) return 0;
+
+    // polygon fill wants clockwise points
+    tpts[0] = pts[0];
+    if (cross > 0)
+    {
+        tpts[1] = pts[1];
+        tpts[2] = pts[2];
+    }
+    else
+    {
+        tpts[1] = pts[2];
+        tpts[2] = pts[1];
+    }
+
+    a0 = &attrs[0];
+    a1 = &attrs[numAttr];
+    a2 = &attrs[numAttr * 2];
+
+    // attributes plane, gradients are scaled to the attribute format:
+    // color and texel row offset --> 16.16, texel byte offset --> 15.17
+    for(i = 0; i < numAttr; i++)
+    {
+        const s32 d1 = a1[i] - a0[i];
+        const s32 d2 = a2[i] - a0[i];
+        u16 sft;
+        u32 dadx, dady;
+
+        if (mode == FILL_SHADED) sft = 16 - ATTR_FRAC_BITS;
+        else if (i == 0) sft = 15 - ATTR_FRAC_BITS;
+        else sft = (16 - ATTR_FRAC_BITS) + texShift;
+
+        dadx = ((u32) divAttr((d1 * ey2) - (d2 * ey1), cross)) << sft;
+        dady = ((u32) divAttr((d2 * ex1) - (d1 * ex2), cross)) << sft;
+
+        bmp_fill.dadx[i] = dadx;
+        bmp_fill.dady[i] = dady;
+        // value at (0, 0), wrap around doesn't matter as only values at drawn pixels are used
+        bmp_fill.org[i] = (((u32) a0[i]) << (ATTR_FRAC_BITS + sft)) - (dadx * pts[0].x) - (dady * pts[0].y);
+    }
+
+    // modified rows
+    markRows(yMin, yMax);
+
+    // same edges and clipping as flat polygon, only spans filling differs
+    bmp_fill.mode = IS_4BPP?(mode + (FILL_SHADED_4BPP - FILL_SHADED)):mode;
+    if (IS_TILEORDER) res = drawPolygonTile(tpts, 3, 0);
+    else res = drawPolygonLinear(tpts, 3, 0);
+    bmp_fill.mode = FILL_FLAT;
+
+    return res;
+}
+
+// (n << ATTR_FRAC_BITS) / d without overflow (|d| < 2^30)
+static s32 divAttr(s32 n, s32 d)
+{
+    const u32 ad = (d < 0)?-d:d;
+    s32 q, r;
+    u16 sft, step;
+
+    // fast path
+    if ((n < 0x80000) && (n > -0x80000)) return (n << ATTR_FRAC_BITS) / d;
+
+    // long division, the fraction is computed in several steps so shifted remainder fits in 32 bits
+    q = n / d;
+    r = n - (q * d);
+
+    step = 1;
+    while((step < ATTR_FRAC_BITS) && (ad < (((u32) 0x40000000) >> step))) step++;
+
+    sft = ATTR_FRAC_BITS;
+    while(sft)
+    {
+        const u16 s = (step > sft)?sft:step;
+        s32 t;
+
+        r <<= s;
+        t = r / d;
+        q = (q << s) + t;
+        r -= t * d;
+        sft -= s;
+    }
+
+    return q;
+}
+
+// 32 x 16 bits multiply from 2 16 bits multiplies (n >= 0)
+static s32 mulAttr(s32 a, u16 n)
+{
+    return (((u32) ((s16) (a >> 16) * (s16) n)) << 16) + ((u32) ((u16) a) * n);
+}
+
+static void fillSpanShadedTile(u8 *row, s16 xl, s16 xr, s16 y)
+{
+    const u16 *dither = &dither4x4[(y & 3) << 2];
+    s32 c = bmp_fill.org[0] + mulAttr(bmp_fill.dady[0], y);
+    s32 dc = bmp_fill.dadx[0];
+    s16 x;
+
+    if (bmp_fill.mode == FILL_SHADED_4BPP)
+    {
+        c += mulAttr(dc, xl);
+
+        for(x = xl; x <= xr; x++)
+        {
+            s16 col = (c + dither[x & 3]) >> 16;
+
+            if (col < 0) col = 0;
+            else if (col > 15) col = 15;
+
+            BMP_SETNIBBLE(&row[TILEX(x >> 1)], x, col)
+
+            c += dc;
+        }
+    }
+    else
+    {
+        // X doubled mode --> one byte (2 pixels) per step, color sampled on even pixel
+        c += mulAttr(dc, xl & ~1);
+        dc <<= 1;
+
+        for(x = xl >> 1; x <= (xr >> 1); x++)
+        {
+            s16 col = (c + dither[x & 3]) >> 16;
+
+            if (col < 0) col = 0;
+            else if (col > 15) col = 15;
+
+            row[TILEX(x)] = col * 0x11;
+
+            c += dc;
+        }
+    }
+}
+
+static void fillSpanTexturedTile(u8 *row, s16 xl, s16 xr, s16 y)
+{
+    const u8 *image = bmp_fill.texImage;
+    const u16 umask = bmp_fill.texUMask;
+    const u16 vmask = bmp_fill.texVMask;
+    s32 u = bmp_fill.org[0] + mulAttr(bmp_fill.dady[0], y);
+    s32 v = bmp_fill.org[1] + mulAttr(bmp_fill.dady[1], y);
+    s32 du = bmp_fill.dadx[0];
+    s32 dv = bmp_fill.dadx[1];
+    s16 x;
+
+    if (bmp_fill.mode == FILL_TEXTURED_4BPP)
+    {
+        u += mulAttr(du, xl);
+        v += mulAttr(dv, xl);
+
+        for(x = xl; x <= xr; x++)
+        {
+            const u8 texel = image[((v >> 16) & vmask) + ((u >> 16) & umask)];
+
+            BMP_SETNIBBLE(&row[TILEX(x >> 1)], x, (u & 0x8000)?(texel & 0xF):(texel >> 4))
+
+            u += du;
+            v += dv;
+        }
+    }
+    else
+    {
+        // X doubled mode --> one byte (2 pixels) per step, texel sampled on even pixel
+        u += mulAttr(du, xl & ~1);
+        v += mulAttr(dv, xl & ~1);
+        du <<= 1;
+        dv <<= 1;
+
+        for(x = xl >> 1; x <= (xr >> 1); x++)
+        {
+            const u8 texel = image[((v >> 16) & vmask) + ((u >> 16) & umask)];
+
+            row[TILEX(x)] = (u & 0x8000)?((texel & 0xF) * 0x11):((texel >> 4) * 0x11);
+
+            u += du;
+            v += dv;
+        }
+    }
+}
+
 //static void drawLine_old(u16 offset, s16 dx, s16 dy, s16 step_x, s16 step_y, u8 col)
 //{
 //    const u8 c = col;
@@ -2,7 +2,10 @@
     .type    clearBitmapBuffer, @function
 clearBitmapBuffer:
     move.l 4(%sp),%a0           | a0 = buffer
-    lea 20480(%a0),%a0          | a0 = buffer end
+    move.w bmp_height,%d0
+    ext.l %d0
+    lsl.l #7,%d0                | d0 = bmp_height * BMP_PITCH
+    add.l %d0,%a0               | a0 = buffer end
 
     movm.l %d2-%d7/%a2-%a6,-(%sp)
 
@@ -20,9 +23,17 @@ clearBitmapBuffer:
     move.l %d1,%a5
     move.l %d1,%a6
 
-    moveq #38,%d0
+    move.w bmp_height,%d0
+    lsr.w #3,%d0
+    subq.w #1,%d0               | d0 = (bmp_height / 8) - 1
 
-.L01:
+.L01:                           | clear a tile row (1024 bytes = 19 * 52 + 36)
+    movm.l %d1-%d7/%a1-%a6,-(%a0)
+    movm.l %d1-%d7/%a1-%a6,-(%a0)
+    movm.l %d1-%d7/%a1-%a6,-(%a0)
+    movm.l %d1-%d7/%a1-%a6,-(%a0)
+    movm.l %d1-%d7/%a1-%a6,-(%a0)
+    movm.l %d1-%d7/%a1-%a6,-(%a0)
     movm.l %d1-%d7/%a1-%a6,-(%a0)
     movm.l %d1-%d7/%a1-%a6,-(%a0)
     movm.l %d1-%d7/%a1-%a6,-(%a0)
@@ -33,12 +44,11 @@ clearBitmapBuffer:
     movm.l %d1-%d7/%a1-%a6,-(%a0)
     movm.l %d1-%d7/%a1-%a6,-(%a0)
     movm.l %d1-%d7/%a1-%a6,-(%a0)
-    dbra %d0,.L01
-
     movm.l %d1-%d7/%a1-%a6,-(%a0)
     movm.l %d1-%d7/%a1-%a6,-(%a0)
     movm.l %d1-%d7/%a1-%a6,-(%a0)
-    movm.l %d1-%d7/%a1-%a4,-(%a0)
+    movm.l %d1-%d7/%a1-%a2,-(%a0)
+    dbra %d0,.L01
 
     movm.l (%sp)+,%d2-%d7/%a2-%a6
     rts
@@ -55,7 +65,7 @@ clearBitmapBuffer:
     | OUT:
     | d0 = ZFLAG = 0 if outside screen
     |              1 if inside screen
-    | d1 = BMP_HEIGHT - 1
+    | d1 = bmp_height - 1
     | d2 = x1
     | d3 = y1
     | d4 = x2
@@ -63,8 +73,10 @@ clearBitmapBuffer:
     | d6-d7 = ??
 clipLine:
 
-    move.w #255,%d0             | d0 = BMP_WIDTH - 1
-    move.w #159,%d1             | d1 = BMP_HEIGHT - 1
+    move.w bmp_width,%d0
+    subq.w #1,%d0               | d0 = bmp_width - 1
+    move.w bmp_height,%d1
+    subq.w #1,%d1               | d1 = bmp_height - 1
 
     cmp.w %d0,%d2               | if (((u16) x1 < BMP_WIDTH) &&
     jhi .L50
@@ -223,9 +235,9 @@ BMP_clipLine:
     rts
 
 
-    .globl    BMP_drawLine
-    .type    BMP_drawLine, @function
-BMP_drawLine:
+    .globl    drawLineLinear
+    .type    drawLineLinear, @function
+drawLineLinear:
     movm.l %d2-%d7,-(%sp)
 
     move.l 28(%sp),%a0      | a0 = &line
@@ -302,6 +314,128 @@ BMP_drawLine:
     rts
 
 
+    .globl    drawLine4bppLinear
+    .type    drawLine4bppLinear, @function
+drawLine4bppLinear:
+    movm.l %d2-%d7/%a2,-(%sp)
+
+    move.l 32(%sp),%a0      | a0 = &line
+    movem.w (%a0)+,%d2-%d5  | d2 = x1, d3 = y1, d4 = x2, d5 = y2
+
+    jsr clipLine
+    jeq .L115
+
+    moveq #15,%d7
+    and.b (%a0),%d7         | d7 = col & 0xF
+    move.b %d7,%d0
+    lsl.b #4,%d0
+    or.b %d0,%d7            | d7 = col in both nibbles
+
+    sub.w %d2,%d4           | d4 = deltax
+    sub.w %d3,%d5           | d5 = deltay
+
+    lsl.w #7,%d3            | d3 = y1 * BMP_PITCH
+    move.l bmp_buffer_write,%a1
+    add.w %d3,%a1           | a1 = row = &bmp_buffer_write[y1 * BMP_PITCH] (can be 16 bits as row is in RAM)
+
+    move.w #1,%a2           | a2 = stepx = 1
+
+    tst.w %d4               | if (deltax < 0)
+    jge .L106               | {
+
+    neg.w %d4               |     deltax = -deltax;
+    move.w #-1,%a2          |     stepx = -stepx;
+                            | }
+.L106:
+    move.w #128,%a0         | a0 = stepy = BMP_PITCH;
+
+    tst.w %d5               | if (deltay < 0)
+    jge .L107               | {
+
+    neg.w %d5               |     deltay = -deltay;
+    move.w #-128,%a0        |     stepy = -stepy;
+                            | }
+.L107:                      |
+    cmp.w %d4,%d5           | if (deltax < deltay)
+    jgt .L111               |     goto y major
+
+    move.w %d4,%d6
+    asr.w #1,%d6            | d6 = delta = dx >> 1
+    move.w %d4,%d3          | d3 = cnt
+
+.L108:                      | while(cnt--)
+                            | {
+    move.w %d2,%d0
+    lsr.w #1,%d0            |     d0 = x >> 1 (C = odd pixel)
+    jcs .L109
+
+    move.b (%a1,%d0.w),%d1
+    eor.b %d7,%d1
+    andi.b #0x0F,%d1        |     even pixel --> high nibble
+    eor.b %d7,%d1
+    move.b %d1,(%a1,%d0.w)
+    jra .L110
+
+.L109:
+    move.b (%a1,%d0.w),%d1
+    eor.b %d7,%d1
+    andi.b #0xF0,%d1        |     odd pixel --> low nibble
+    eor.b %d7,%d1
+    move.b %d1,(%a1,%d0.w)
+
+.L110:
+    add.w %a2,%d2           |     x += stepx;
+    sub.w %d5,%d6           |     if ((delta -= dy) < 0)
+    jpl .L114               |     {
+    add.w %a0,%a1           |         row += stepy;
+    add.w %d4,%d6           |         delta += dx;
+                            |     }
+.L114:
+    dbra %d3,.L108          | }
+
+    movm.l (%sp)+,%d2-%d7/%a2
+    rts
+
+.L111:
+    move.w %d5,%d6
+    asr.w #1,%d6            | d6 = delta = dy >> 1
+    move.w %d5,%d3          | d3 = cnt
+
+.L112:                      | while(cnt--)
+                            | {
+    move.w %d2,%d0
+    lsr.w #1,%d0            |     d0 = x >> 1 (C = odd pixel)
+    jcs .L113
+
+    move.b (%a1,%d0.w),%d1
+    eor.b %d7,%d1
+    andi.b #0x0F,%d1        |     even pixel --> high nibble
+    eor.b %d7,%d1
+    move.b %d1,(%a1,%d0.w)
+    jra .L116
+
+.L113:
+    move.b (%a1,%d0.w),%d1
+    eor.b %d7,%d1
+    andi.b #0xF0,%d1        |     odd pixel --> low nibble
+    eor.b %d7,%d1
+    move.b %d1,(%a1,%d0.w)
+
+.L116:
+    add.w %a0,%a1           |     row += stepy;
+    sub.w %d4,%d6           |     if ((delta -= dx) < 0)
+    jpl .L117               |     {
+    add.w %a2,%d2           |         x += stepx;
+    add.w %d5,%d6           |         delta += dy;
+                            |     }
+.L117:
+    dbra %d3,.L112          | }
+
+.L115:
+    movm.l (%sp)+,%d2-%d7/%a2
+    rts
+
+
     .globl    BMP_isPolygonCulled
     .type    BMP_isPolygonCulled, @function
 BMP_isPolygonCulled:
@@ -1566,9 +1700,9 @@ fillEdgeFast:
     | a3 = rightEdge
     | a4 = free use
 
-    .globl    BMP_drawPolygon
-    .type    BMP_drawPolygon, @function
-BMP_drawPolygon:
+    .globl    drawPolygonLinear
+    .type    drawPolygonLinear, @function
+drawPolygonLinear:
     movm.l %d2-%d7/%a2-%a6,-(%sp)
 
     move.l 48(%sp),%a0      | a0 = pt = &pts[0]
@@ -1642,12 +1776,15 @@ BMP_drawPolygon:
     tst.w %d5               | if (xMax < 0)
     jlt .DP_end0            |   return 0
 
-    move.l #159,%d6         | d6 = BMP_HEIGHT-1
+    moveq #0,%d6
+    move.w bmp_height,%d6
+    subq.w #1,%d6           | d6 = bmp_height - 1
 
     cmp.w %d6,%d2           | if (yMin > BMP_HEIGHT)
     jgt .DP_end0            |   return 0
 
-    move.l #255,%a3         | a3 = BMP_WIDTH-1
+    move.w bmp_width,%a3
+    subq.w #1,%a3           | a3 = bmp_width - 1
 
     cmp.w %a3,%d4           | if (xMin > BMP_WIDTH)
     jgt .DP_end0            |   return 0
@@ -2531,6 +2668,9 @@ BMP_drawPolygon:
     sub.w %d2,%d6               | d6 = len = maxY - minY
     jlt .dp_end0                | < 0 = nothing to draw --> exit
 
+    tst.w bmp_fill+28           | shaded or textured fill ?
+    jne .drawPolygonAttr
+
     move.b 644+59(%sp),%d1     | d1 = col
 
     move.b %d1,-(%sp)
@@ -3061,3 +3201,464 @@ BMP_drawPolygon:
     moveq #1,%d0
     movm.l (%sp)+,%d2-%d7/%a2-%a6
     rts
+
+    | shaded / textured polygon drawing (bmp_fill.mode != FILL_FLAT)
+    | --------------------------------------------------------------
+    | same edge table and clipping as flat polygon, span filling is done
+    | by the routine selected from bmp_fill.mode
+    |
+    | d2 = minY
+    | d6 = len
+.drawPolygonAttr:
+    lea bmp_fill,%a5            | a5 = &bmp_fill
+
+    move.w %d2,%d0
+    add.w %d0,%d0               | d0 = minY * 2
+    lea 0(%sp,%d0.w),%a2        | a2 = edgeL = &leftEdge[minY]
+    lea 320(%a2),%a3            | a3 = edgeR = &rightEdge[minY]
+
+    move.l bmp_buffer_write,%a0
+    lsl.w  #6,%d0
+    add.w  %d0,%a0              | a0 = buf = &bmp_buffer_write[minY * BMP_PITCH]
+
+    move.l 20(%a5),%d0
+    move.w %d2,%d1
+    jsr mulAttr
+    move.l 4(%a5),%d7
+    add.l %d0,%d7               | d7 = row0 = org[0] + (dady[0] * minY)
+
+    move.l 24(%a5),%d0
+    move.w %d2,%d1
+    jsr mulAttr
+    move.l 8(%a5),%a4
+    add.l %d0,%a4               | a4 = row1 = org[1] + (dady[1] * minY)
+
+    move.w 28(%a5),%d0
+    add.w %d0,%d0
+    add.w %d0,%d0               | d0 = mode * 4
+    lea .pa_span_table-4(%pc),%a6
+    move.l (%a6,%d0.w),%a6      | a6 = span fill routine
+
+                                | while (len--)
+.pa_loop:                       | {
+    move.w (%a2)+,%d4           |   xl = *edgeL
+    jge .pa_xl_ok
+
+    moveq #0,%d4
+
+.pa_xl_ok:
+    move.w (%a3)+,%d5           |   xr = *edgeR
+    cmp.w %d4,%d5               |   if (xr < xl) continue;
+    jlt .pa_next
+
+    movm.l %d2/%d6-%d7/%a0/%a2-%a4/%a6,-(%sp)
+    jsr (%a6)                   |   fillSpanXXX(buf, xl, xr, y)
+    movm.l (%sp)+,%d2/%d6-%d7/%a0/%a2-%a4/%a6
+
+.pa_next:
+    lea 128(%a0),%a0
+    addq.w #1,%d2               |   y++
+    add.l 20(%a5),%d7           |   row0 += dady[0]
+    add.l 24(%a5),%a4           |   row1 += dady[1]
+    dbra %d6,.pa_loop           | }
+
+    lea 644(%sp),%sp            | release memory for edge table and others
+    moveq #1,%d0
+    movm.l (%sp)+,%d2-%d7/%a2-%a6
+    rts
+
+    .align 4
+
+.pa_span_table:
+    .long fillSpanShaded
+    .long fillSpanTextured
+    .long fillSpanShaded4bpp
+    .long fillSpanTextured4bpp
+
+    | 4x4 ordered dither (16 bits fraction), same table as in bmp.c
+.dither_table:
+    .long 2048,34816,10240,43008
+    .long 51200,18432,59392,26624
+    .long 14336,47104,6144,38912
+    .long 63488,30720,55296,22528
+
+
+    | 32 x 16 bits multiply
+    |
+    | IN:
+    | d0 = a
+    | d1 = n (>= 0)
+    |
+    | OUT:
+    | d0 = a * n
+    | d3 = ?
+mulAttr:
+    move.w %d0,%d3
+    mulu.w %d1,%d3          | d3 = (a & 0xFFFF) * n
+    swap %d0
+    muls.w %d1,%d0
+    swap %d0
+    clr.w %d0               | d0 = ((a >> 16) * n) << 16
+    add.l %d3,%d0
+    rts
+
+
+    | span fill routines (called from .drawPolygonAttr)
+    |
+    | IN:
+    | d2 = y
+    | d4 = xl (>= 0)
+    | d5 = xr (>= xl)
+    | d7 = attribute 0 at (0, y)
+    | a4 = attribute 1 at (0, y)
+    | a0 = buf = &bmp_buffer_write[y * BMP_PITCH]
+    | a5 = &bmp_fill
+    |
+    | all registers except a5 can be modified
+
+
+    | d0.w = color (clamped dithered c) then step c
+    |
+    | d2 = 15
+    | d3 = dither index
+    | d4 = 12 (dither index mask)
+    | d6 = dc
+    | d7 = c
+    | a2 = dither row
+shadePixel:
+    move.l %d7,%d0
+    add.l (%a2,%d3.w),%d0
+    swap %d0                | d0 = (c + dither) >> 16
+    cmp.w %d2,%d0           | if ((col < 0) || (col > 15))
+    jls .sp_col_ok
+
+    tst.w %d0
+    spl %d0
+    and.w %d2,%d0           |   col = (col < 0)?0:15
+
+.sp_col_ok:
+    add.l %d6,%d7           | c += dc
+    addq.w #4,%d3
+    and.w %d4,%d3           | next dither
+    rts
+
+
+    | X doubled mode: one byte (2 pixels) per step, color sampled on even pixel
+fillSpanShaded:
+    move.l 12(%a5),%d0
+    moveq #-2,%d1
+    and.w %d4,%d1
+    jsr mulAttr
+    add.l %d0,%d7               | d7 = c = row0 + (dadx[0] * (xl & ~1))
+    move.l 12(%a5),%d6
+    add.l %d6,%d6               | d6 = dc = dadx[0] * 2
+
+    and.w #3,%d2
+    lsl.w #4,%d2
+    lea .dither_table(%pc),%a2
+    add.w %d2,%a2               | a2 = dither row = &dither[(y & 3) * 4]
+    moveq #15,%d2
+
+    asr.w #1,%d4                | d4 = bl = xl >> 1
+    lea (%a0,%d4.w),%a1         | a1 = dst = &buf[bl]
+    asr.w #1,%d5
+    sub.w %d4,%d5               | d5 = len = (xr >> 1) - bl
+
+    moveq #3,%d3
+    and.w %d4,%d3
+    add.w %d3,%d3
+    add.w %d3,%d3               | d3 = dither index = (bl & 3) * 4
+    moveq #12,%d4
+
+.fss_loop:
+    move.l %d7,%d0
+    add.l (%a2,%d3.w),%d0
+    swap %d0                    | d0 = col = (c + dither) >> 16
+    cmp.w %d2,%d0
+    jhi .fss_clamp
+
+.fss_col_ok:
+    move.b %d0,%d1
+    lsl.b #4,%d1
+    or.b %d1,%d0
+    move.b %d0,(%a1)+           | *dst++ = col * 0x11
+
+    add.l %d6,%d7               | c += dc
+    addq.w #4,%d3
+    and.w %d4,%d3               | next dither
+    dbra %d5,.fss_loop
+    rts
+
+.fss_clamp:
+    tst.w %d0
+    spl %d0
+    and.w %d2,%d0               | col = (col < 0)?0:15
+    jra .fss_col_ok
+
+
+fillSpanShaded4bpp:
+    move.l 12(%a5),%d6          | d6 = dc = dadx[0]
+    move.l %d6,%d0
+    move.w %d4,%d1
+    jsr mulAttr
+    add.l %d0,%d7               | d7 = c = row0 + (dadx[0] * xl)
+
+    and.w #3,%d2
+    lsl.w #4,%d2
+    lea .dither_table(%pc),%a2
+    add.w %d2,%a2               | a2 = dither row = &dither[(y & 3) * 4]
+    moveq #15,%d2
+
+    moveq #3,%d3
+    and.w %d4,%d3
+    add.w %d3,%d3
+    add.w %d3,%d3               | d3 = dither index = (xl & 3) * 4
+
+    move.w %d5,%d0
+    addq.w #1,%d0
+    asr.w #1,%d0
+    lea (%a0,%d0.w),%a3         | a3 = end = &buf[(xr + 1) >> 1]
+
+    asr.w #1,%d4
+    lea (%a0,%d4.w),%a1         | a1 = dst = &buf[xl >> 1]
+    jcc .fs4_even               | if (xl & 1)
+                                | {
+    moveq #12,%d4
+    jsr shadePixel
+    andi.b #0xF0,(%a1)
+    or.b %d0,(%a1)+             |   odd pixel --> low nibble
+    jra .fs4_pairs              | }
+
+.fs4_even:
+    moveq #12,%d4
+
+.fs4_pairs:
+    cmp.l %a3,%a1               | while (dst < end)
+    jcc .fs4_last               | {
+
+.fs4_loop:
+    move.l %d7,%d0
+    add.l (%a2,%d3.w),%d0
+    swap %d0                    |   d0 = col = (c + dither) >> 16
+    cmp.w %d2,%d0
+    jhi .fs4_clamp0
+
+.fs4_col0_ok:
+    lsl.b #4,%d0                |   even pixel --> high nibble
+    add.l %d6,%d7               |   c += dc
+    addq.w #4,%d3
+    and.w %d4,%d3               |   next dither
+
+    move.l %d7,%d1
+    add.l (%a2,%d3.w),%d1
+    swap %d1                    |   d1 = col = (c + dither) >> 16
+    cmp.w %d2,%d1
+    jhi .fs4_clamp1
+
+.fs4_col1_ok:
+    or.b %d1,%d0                |   odd pixel --> low nibble
+    move.b %d0,(%a1)+
+    add.l %d6,%d7               |   c += dc
+    addq.w #4,%d3
+    and.w %d4,%d3               |   next dither
+
+    cmp.l %a3,%a1
+    jcs .fs4_loop               | }
+
+.fs4_last:
+    btst #0,%d5                 | if (!(xr & 1))
+    jne .fs4_end                | {
+
+    jsr shadePixel
+    lsl.b #4,%d0
+    andi.b #0x0F,(%a1)
+    or.b %d0,(%a1)              |   even pixel --> high nibble
+                                | }
+.fs4_end:
+    rts
+
+.fs4_clamp0:
+    tst.w %d0
+    spl %d0
+    and.w %d2,%d0               | col = (col < 0)?0:15
+    jra .fs4_col0_ok
+
+.fs4_clamp1:
+    tst.w %d1
+    spl %d1
+    and.w %d2,%d1               | col = (col < 0)?0:15
+    jra .fs4_col1_ok
+
+
+    | d0.b = texel pixel at (u, v) then step u and v
+    |
+    | d2 = umask
+    | d3 = vmask
+    | d5 = dv
+    | d6 = du
+    | d7 = u
+    | a4 = v
+    | a6 = texture image
+texelPixel:
+    move.l %a4,%d0
+    swap %d0
+    and.w %d3,%d0               | d0 = (v >> 16) & vmask
+    move.l %d7,%d1
+    swap %d1
+    and.w %d2,%d1
+    add.w %d1,%d0               | d0 = texel offset
+    move.b (%a6,%d0.w),%d0      | d0 = texel (2 pixels)
+
+    tst.w %d7                   | if (u & 0x8000)
+    jpl .tp_high
+    lsl.b #4,%d0                |   texel odd pixel is low nibble
+
+.tp_high:
+    lsr.b #4,%d0                | d0 = pixel
+    add.l %d6,%d7               | u += du
+    add.l %d5,%a4               | v += dv
+    rts
+
+
+    | X doubled mode: one byte (2 pixels) per step, texel sampled on even pixel
+fillSpanTextured:
+    move.l 12(%a5),%d0
+    moveq #-2,%d1
+    and.w %d4,%d1
+    jsr mulAttr
+    add.l %d0,%d7               | d7 = u = row0 + (dadx[0] * (xl & ~1))
+    move.l 16(%a5),%d0
+    moveq #-2,%d1
+    and.w %d4,%d1
+    jsr mulAttr
+    add.l %d0,%a4               | a4 = v = row1 + (dadx[1] * (xl & ~1))
+
+    asr.w #1,%d4
+    lea (%a0,%d4.w),%a1         | a1 = dst = &buf[xl >> 1]
+    asr.w #1,%d5
+    sub.w %d4,%d5               | d5 = len = (xr >> 1) - (xl >> 1)
+
+    move.l 12(%a5),%d6
+    add.l %d6,%d6               | d6 = du = dadx[0] * 2
+    move.l 16(%a5),%d4
+    add.l %d4,%d4               | d4 = dv = dadx[1] * 2
+    move.w 30(%a5),%d2          | d2 = umask
+    move.w 32(%a5),%d3          | d3 = vmask
+    move.l (%a5),%a6            | a6 = texture image
+
+.fst_loop:
+    move.l %a4,%d0
+    swap %d0
+    and.w %d3,%d0               | d0 = (v >> 16) & vmask
+    move.l %d7,%d1
+    swap %d1
+    and.w %d2,%d1
+    add.w %d1,%d0               | d0 = texel offset
+    move.b (%a6,%d0.w),%d0      | d0 = texel (2 pixels)
+
+    tst.w %d7                   | if (u & 0x8000)
+    jpl .fst_high
+    lsl.b #4,%d0                |   texel odd pixel is low nibble
+
+.fst_high:
+    andi.b #0xF0,%d0
+    move.b %d0,%d1
+    lsr.b #4,%d1
+    or.b %d1,%d0
+    move.b %d0,(%a1)+           | *dst++ = pixel * 0x11
+
+    add.l %d6,%d7               | u += du
+    add.l %d4,%a4               | v += dv
+    dbra %d5,.fst_loop
+    rts
+
+
+fillSpanTextured4bpp:
+    move.l 12(%a5),%d0
+    move.w %d4,%d1
+    jsr mulAttr
+    add.l %d0,%d7               | d7 = u = row0 + (dadx[0] * xl)
+    move.l 16(%a5),%d0
+    move.w %d4,%d1
+    jsr mulAttr
+    add.l %d0,%a4               | a4 = v = row1 + (dadx[1] * xl)
+
+    move.w %d5,-(%sp)           | save xr
+
+    move.w %d5,%d0
+    addq.w #1,%d0
+    asr.w #1,%d0
+    lea (%a0,%d0.w),%a3         | a3 = end = &buf[(xr + 1) >> 1]
+
+    move.l 12(%a5),%d6          | d6 = du = dadx[0]
+    move.l 16(%a5),%d5          | d5 = dv = dadx[1]
+    move.w 30(%a5),%d2          | d2 = umask
+    move.w 32(%a5),%d3          | d3 = vmask
+    move.l (%a5),%a6            | a6 = texture image
+
+    asr.w #1,%d4
+    lea (%a0,%d4.w),%a1         | a1 = dst = &buf[xl >> 1]
+    jcc .ft4_pairs              | if (xl & 1)
+                                | {
+    jsr texelPixel
+    andi.b #0xF0,(%a1)
+    or.b %d0,(%a1)+             |   odd pixel --> low nibble
+                                | }
+.ft4_pairs:
+    cmp.l %a3,%a1               | while (dst < end)
+    jcc .ft4_last               | {
+
+.ft4_loop:
+    move.l %a4,%d0
+    swap %d0
+    and.w %d3,%d0               |   d0 = (v >> 16) & vmask
+    move.l %d7,%d1
+    swap %d1
+    and.w %d2,%d1
+    add.w %d1,%d0               |   d0 = texel offset
+    move.b (%a6,%d0.w),%d0      |   d0 = texel (2 pixels)
+
+    tst.w %d7                   |   if (u & 0x8000)
+    jpl .ft4_high0
+    lsl.b #4,%d0                |     texel odd pixel is low nibble
+
+.ft4_high0:
+    andi.b #0xF0,%d0            |   even pixel --> high nibble
+    add.l %d6,%d7               |   u += du
+    add.l %d5,%a4               |   v += dv
+
+    move.l %a4,%d1
+    swap %d1
+    and.w %d3,%d1               |   d1 = (v >> 16) & vmask
+    move.l %d7,%d4
+    swap %d4
+    and.w %d2,%d4
+    add.w %d4,%d1               |   d1 = texel offset
+    move.b (%a6,%d1.w),%d1      |   d1 = texel (2 pixels)
+
+    tst.w %d7                   |   if (u & 0x8000)
+    jpl .ft4_high1
+    lsl.b #4,%d1                |     texel odd pixel is low nibble
+
+.ft4_high1:
+    lsr.b #4,%d1
+    or.b %d1,%d0                |   odd pixel --> low nibble
+    move.b %d0,(%a1)+
+    add.l %d6,%d7               |   u += du
+    add.l %d5,%a4               |   v += dv
+
+    cmp.l %a3,%a1
+    jcs .ft4_loop               | }
+
+.ft4_last:
+    move.w (%sp)+,%d4           | d4 = xr
+    btst #0,%d4                 | if (!(xr & 1))
+    jne .ft4_end                | {
+
+    jsr texelPixel
+    lsl.b #4,%d0
+    andi.b #0x0F,(%a1)
+    or.b %d0,(%a1)              |   even pixel --> high nibble
+                                | }
+.ft4_end:
+    rts
@@ -57,6 +57,9 @@ void DMA_flushQueue()
         *pl = *info++;  // regCtrlWrite =  GFX_DMA_VRAMCOPY_ADDR(to)
     }
 
+    // each transfer set its own auto increment step --> restore the one expected by VDP_getAutoInc()
+    if (queueIndex) *((vu16*) pl) = 0x8F00 | VDP_getAutoInc();
+
     queueIndex = 0;
     queueTransferSize = 0;
 }
@@ -0,0 +1,166 @@
+#include "config.h"
+#include "types.h"
+
+#include "hud.h"
+
+#include "vdp.h"
+#include "tilemap_buf.h"
+#include "string.h"
+#include "maths.h"
+
+
+// HUD tilemap buffer
+static TileMapBuffer buffer;
+// HUD initialized
+static u16 hudInitialized = FALSE;
+
+
+u16 HUD_init(u16 h, u16 bottom)
+{
+    const u16 rows = VDP_getScreenHeight() >> 3;
+    u16 y;
+
+    if (hudInitialized) HUD_end();
+
+    if (bottom) y = rows - h;
+    else y = 0;
+
+    if (!TMB_init(&buffer, WINDOW, 0, y, VDP_getScreenWidth() >> 3, h)) return FALSE;
+
+    // no horizontal window area, vertical window area covers the HUD rows
+    VDP_setReg(0x11, 0);
+    if (bottom) VDP_setReg(0x12, 0x80 | y);
+    else VDP_setReg(0x12, h);
+
+    hudInitialized = TRUE;
+
+    return TRUE;
+}
+
+void HUD_end()
+{
+    if (!hudInitialized) return;
+
+    // disable window
+    VDP_setReg(0x12, 0);
+    TMB_release(&buffer);
+
+    hudInitialized = FALSE;
+}
+
+TileMapBuffer *HUD_getBuffer()
+{
+    return &buffer;
+}
+
+
+void HUD_drawText(const char *str, u16 flags, u16 x, u16 y)
+{
+    u16 data[64];
+    const char *src;
+    u16 len;
+
+    src = str;
+    len = 0;
+    while(*src && (len < 64)) data[len++] = TILE_FONTINDEX + (*src++ - 32);
+
+    TMB_setTileMapRect(&buffer, data, flags, x, y, len, 1, len);
+}
+
+void HUD_clearText(u16 x, u16 y, u16 w)
+{
+    TMB_fillRect(&buffer, 0, x, y, w, 1);
+}
+
+
+void HUD_initNumber(HudNumber *number, u16 x, u16 y, u16 len, u16 flags, u16 zeroPad)
+{
+    number->x = x;
+    number->y = y;
+    number->len = min(len, HUD_NUMBER_MAX_LEN);
+    number->flags = flags;
+    number->zeroPad = zeroPad;
+    number->value = 0;
+    number->drawn = FALSE;
+}
+
+void HUD_setNumber(HudNumber *number, u32 value)
+{
+    const u16 len = number->len;
+    char str[16];
+    u16 data[HUD_NUMBER_MAX_LEN];
+    const char *src;
+    u16 strLen;
+    u16 i;
+
+    // same value already displayed --> nothing to do
+    if (number->drawn && (number->value == value)) return;
+
+    number->value = value;
+    number->drawn = TRUE;
+
+    uintToStr(value, str, number->zeroPad?len:1);
+    strLen = strlen(str);
+
+    // too large --> keep lowest digits
+    if (strLen > len)
+    {
+        src = &str[strLen - len];
+        strLen = len;
+    }
+    else src = str;
+
+    // right alignment
+    i = 0;
+    while(i < (len - strLen)) data[i++] = 0;
+    while(i < len) data[i++] = TILE_FONTINDEX + (*src++ - 32);
+
+    TMB_setTileMapRect(&buffer, data, number->flags, number->x, number->y, len, 1, len);
+}
+
+
+void HUD_initBar(HudBar *bar, u16 x, u16 y, u16 len, u16 basetile, u16 max)
+{
+    bar->x = x;
+    bar->y = y;
+    bar->len = min(len, 64);
+    bar->basetile = basetile;
+    bar->max = max;
+    bar->fill = 0;
+    bar->drawn = FALSE;
+}
+
+void HUD_setBar(HudBar *bar, u16 value)
+{
+    u16 data[64];
+    u16 fill;
+    u16 i;
+
+    if (value > bar->max) value = bar->max;
+
+    // fill level in pixel
+    if (bar->max) fill = (((u32) value) * (bar->len * 8)) / bar->max;
+    else fill = 0;
+
+    // same fill level already displayed --> nothing to do
+    if (bar->drawn && (bar->fill == fill)) return;
+
+    bar->fill = fill;
+    bar->drawn = TRUE;
+
+    for(i = 0; i < bar->len; i++)
+    {
+        if (fill >= 8)
+        {
+            data[i] = 8;
+            fill -= 8;
+        }
+        else
+        {
+            data[i] = fill;
+            fill = 0;
+        }
+    }
+
+    TMB_setTileMapRect(&buffer, data, bar->basetile, bar->x, bar->y, bar->len, 1, bar->len);
+}
@@ -0,0 +1,436 @@
+#include "config.h"
+#include "types.h"
+
+#include "map_eng.h"
+
+#include "vdp.h"
+#include "vdp_bg.h"
+#include "dma.h"
+#include "tools.h"
+#include "memory.h"
+
+
+// forward
+static void initView(MapScroller *scroller, s16 x, s16 y);
+static void clipPosition(MapScroller *scroller, s16 *x, s16 *y);
+static void drawView(MapScroller *scroller);
+static void updateColumn(MapScroller *scroller, u16 x, u16 y, u16 *buffer, u16 now);
+static void updateRow(MapScroller *scroller, u16 x, u16 y, u16 *buffer, u16 now);
+static void fillTilemap(MapScroller *scroller, u16 x, u16 y, u16 len, u16 column, u16 *dest);
+static const u16 *getBlock(MapScroller *scroller, u16 blockX, u16 blockY);
+static void writeTilemap(u16 addr, const u16 *data, u16 len, u16 step, u16 now);
+
+
+u16 MAP_init(MapScroller *scroller, const Map *map, VDPPlan plan, u16 basetile, s16 x, s16 y)
+{
+    scroller->map = map;
+    scroller->metamap = NULL;
+    scroller->w = map->w;
+    scroller->h = map->h;
+    scroller->plan = plan;
+    scroller->basetile = basetile;
+    scroller->unpacked = NULL;
+    scroller->blocks = NULL;
+
+    // block compressed map --> only unpack visible blocks
+    if (map->compression == COMPRESSION_MAP_BLOCK)
+    {
+        u16 i;
+
+        scroller->blocks = MEM_alloc(MAP_BLOCK_CACHE * MAP_BLOCK_SIZE * MAP_BLOCK_SIZE * 2);
+
+        if (scroller->blocks == NULL) return FALSE;
+
+        for(i = 0; i < MAP_BLOCK_CACHE; i++)
+        {
+            scroller->blockIds[i] = -1;
+            scroller->blockUse[i] = 0;
+        }
+
+        scroller->blockTime = 0;
+        scroller->tilemap = NULL;
+    }
+    // compressed map --> unpack it once
+    else if (map->compression != COMPRESSION_NONE)
+    {
+        Map *m = unpackMap(map, NULL);
+
+        if (m == NULL) return FALSE;
+
+        scroller->unpacked = m;
+        scroller->tilemap = m->tilemap;
+    }
+    else scroller->tilemap = map->tilemap;
+
+    initView(scroller, x, y);
+
+    return TRUE;
+}
+
+void MAP_initMeta(MapScroller *scroller, const MetaMap *metamap, VDPPlan plan, u16 basetile, s16 x, s16 y)
+{
+    u16 shift;
+
+    scroller->map = NULL;
+    scroller->metamap = metamap;
+    scroller->plan = plan;
+    scroller->basetile = basetile;
+    scroller->unpacked = NULL;
+    scroller->blocks = NULL;
+    scroller->tilemap = NULL;
+
+    // metatile size is a power of 2
+    shift = 0;
+    while((1 << shift) < metamap->metaSize) shift++;
+
+    scroller->metaShift = shift;
+    scroller->w = metamap->w << shift;
+    scroller->h = metamap->h << shift;
+
+    initView(scroller, x, y);
+}
+
+void MAP_release(MapScroller *scroller)
+{
+    if (scroller->unpacked)
+    {
+        MEM_free(scroller->unpacked);
+        scroller->unpacked = NULL;
+    }
+    if (scroller->blocks)
+    {
+        MEM_free(scroller->blocks);
+        scroller->blocks = NULL;
+    }
+}
+
+void MAP_scrollTo(MapScroller *scroller, s16 x, s16 y)
+{
+    const u16 viewW = (screenWidth >> 3) + 1;
+    const u16 viewH = (screenHeight >> 3) + 1;
+    s16 tileX, tileY;
+    s16 dx, dy;
+    u16 i;
+
+    clipPosition(scroller, &x, &y);
+
+    // no change
+    if ((x == scroller->x) && (y == scroller->y)) return;
+
+    tileX = x >> 3;
+    tileY = y >> 3;
+    dx = tileX - scroller->tileX;
+    dy = tileY - scroller->tileY;
+
+    // too many column or row to update --> redraw everything
+    if ((dx > MAP_MAX_UPDATE) || (dx < -MAP_MAX_UPDATE) || (dy > MAP_MAX_UPDATE) || (dy < -MAP_MAX_UPDATE))
+    {
+        const u8 enabled = VDP_getEnable();
+
+        scroller->tileX = tileX;
+        scroller->tileY = tileY;
+
+        // whole view is redrawn now (too large for the DMA queue) so blank display and set scroll now
+        // as well, tilemap and scroll values have to change together
+        if (enabled) VDP_setEnable(FALSE);
+        drawView(scroller);
+        VDP_setHorizontalScroll(scroller->plan, -x);
+        VDP_setVerticalScroll(scroller->plan, y);
+        if (enabled) VDP_setEnable(TRUE);
+    }
+    else
+    {
+        // new exposed columns (for new visible rows)
+        if (dx > 0)
+        {
+            for(i = 0; i < dx; i++)
+                updateColumn(scroller, scroller->tileX + viewW + i, tileY, scroller->colBuffer[i], FALSE);
+        }
+        else if (dx < 0)
+        {
+            for(i = 0; i < -dx; i++)
+                updateColumn(scroller, tileX + i, tileY, scroller->colBuffer[i], FALSE);
+        }
+
+        // new exposed rows (for new visible columns)
+        if (dy > 0)
+        {
+            for(i = 0; i < dy; i++)
+                updateRow(scroller, tileX, scroller->tileY + viewH + i, scroller->rowBuffer[i], FALSE);
+        }
+        else if (dy < 0)
+        {
+            for(i = 0; i < -dy; i++)
+                updateRow(scroller, tileX, tileY + i, scroller->rowBuffer[i], FALSE);
+        }
+
+        scroller->tileX = tileX;
+        scroller->tileY = tileY;
+    }
+
+    // send scroll values through DMA queue so they are synchronized with tilemap update
+    if (x != scroller->x)
+    {
+        scroller->hScroll = -x;
+        VDP_getHorizontalScrollTable(scroller->plan)[0] = -x;
+        VDP_queueHorizontalScrollTable(scroller->plan);
+    }
+    if (y != scroller->y)
+    {
+        scroller->vScroll = y;
+        VDP_getVerticalScrollTable(scroller->plan)[0] = y;
+        VDP_queueVerticalScrollTable(scroller->plan);
+    }
+
+    scroller->x = x;
+    scroller->y = y;
+}
+
+
+static void initView(MapScroller *scroller, s16 x, s16 y)
+{
+    clipPosition(scroller, &x, &y);
+
+    scroller->x = x;
+    scroller->y = y;
+    scroller->tileX = x >> 3;
+    scroller->tileY = y >> 3;
+    scroller->hScroll = -x;
+    scroller->vScroll = y;
+
+    // draw whole screen now
+    drawView(scroller);
+
+    VDP_setHorizontalScroll(scroller->plan, scroller->hScroll);
+    VDP_setVerticalScroll(scroller->plan, scroller->vScroll);
+}
+
+static void clipPosition(MapScroller *scroller, s16 *x, s16 *y)
+{
+    const s16 maxX = (scroller->w << 3) - screenWidth;
+    const s16 maxY = (scroller->h << 3) - screenHeight;
+
+    if (*x > maxX) *x = maxX;
+    if (*x < 0) *x = 0;
+    if (*y > maxY) *y = maxY;
+    if (*y < 0) *y = 0;
+}
+
+static void drawView(MapScroller *scroller)
+{
+    const u16 viewH = (screenHeight >> 3) + 1;
+    const u16 tileX = scroller->tileX;
+    u16 y;
+    u16 i;
+
+    // draw all visible rows now
+    y = scroller->tileY;
+    i = viewH;
+    while(i--) updateRow(scroller, tileX, y++, scroller->rowBuffer[0], TRUE);
+}
+
+static void updateColumn(MapScroller *scroller, u16 x, u16 y, u16 *buffer, u16 now)
+{
+    const u16 mapH = scroller->h;
+    const u16 pw = VDP_getPlanWidth();
+    const u16 ph = VDP_getPlanHeight();
+    const u16 plan = (scroller->plan.v == PLAN_A.v)?APLAN:BPLAN;
+    u16 h, len, px, py;
+
+    // outside map
+    if ((x >= scroller->w) || (y >= mapH)) return;
+
+    h = (screenHeight >> 3) + 1;
+    if ((y + h) > mapH) h = mapH - y;
+
+    fillTilemap(scroller, x, y, h, TRUE, buffer);
+
+    // position in plan
+    px = x & (pw - 1);
+    py = y & (ph - 1);
+
+    // split column at plan vertical wrap
+    len = ph - py;
+    if (len > h) len = h;
+
+    writeTilemap(plan + ((px + (py * pw)) * 2), buffer, len, pw * 2, now);
+    if (h > len) writeTilemap(plan + (px * 2), buffer + len, h - len, pw * 2, now);
+}
+
+static void updateRow(MapScroller *scroller, u16 x, u16 y, u16 *buffer, u16 now)
+{
+    const u16 mapW = scroller->w;
+    const u16 pw = VDP_getPlanWidth();
+    const u16 ph = VDP_getPlanHeight();
+    const u16 plan = (scroller->plan.v == PLAN_A.v)?APLAN:BPLAN;
+    u16 w, len, px, py;
+
+    // outside map
+    if ((x >= mapW) || (y >= scroller->h)) return;
+
+    w = (screenWidth >> 3) + 1;
+    if ((x + w) > mapW) w = mapW - x;
+
+    fillTilemap(scroller, x, y, w, FALSE, buffer);
+
+    // position in plan
+    px = x & (pw - 1);
+    py = y & (ph - 1);
+
+    // split row at plan horizontal wrap
+    len = pw - px;
+    if (len > w) len = w;
+
+    writeTilemap(plan + ((px + (py * pw)) * 2), buffer, len, 2, now);
+    if (w > len) writeTilemap(plan + ((py * pw) * 2), buffer + len, w - len, 2, now);
+}
+
+static void fillTilemap(MapScroller *scroller, u16 x, u16 y, u16 len, u16 column, u16 *dest)
+{
+    const u16 baseindex = scroller->basetile & TILE_INDEX_MASK;
+    const u16 baseflags = scroller->basetile & TILE_ATTR_MASK;
+    const u16 *src;
+    u16 *d;
+    u16 remaining;
+    u16 pitch;
+    u16 i;
+
+    d = dest;
+    remaining = len;
+
+    while(remaining)
+    {
+        // plain tilemap --> whole column / row in a single pass
+        if (scroller->tilemap)
+        {
+            src = scroller->tilemap + (y * scroller->w) + x;
+            pitch = column?scroller->w:1;
+            i = remaining;
+        }
+        // metatile map --> process column / row part in current metatile
+        else if (scroller->metamap)
+        {
+            const MetaMap *metamap = scroller->metamap;
+            const u16 shift = scroller->metaShift;
+            const u16 size = 1 << shift;
+            const u16 mx = x & (size - 1);
+            const u16 my = y & (size - 1);
+            const u16 meta = metamap->blockmap[((y >> shift) * metamap->w) + (x >> shift)];
+
+            src = metamap->metatiles + (meta << (shift << 1)) + (my << shift) + mx;
+
+            if (column)
+            {
+                pitch = size;
+                i = size - my;
+            }
+            else
+            {
+                pitch = 1;
+                i = size - mx;
+            }
+
+            if (i > remaining) i = remaining;
+        }
+        // block compressed map --> process column / row part in current block
+        else
+        {
+            const u16 bx = x & (MAP_BLOCK_SIZE - 1);
+            const u16 by = y & (MAP_BLOCK_SIZE - 1);
+
+            src = getBlock(scroller, x / MAP_BLOCK_SIZE, y / MAP_BLOCK_SIZE) + (by * MAP_BLOCK_SIZE) + bx;
+
+            if (column)
+            {
+                pitch = MAP_BLOCK_SIZE;
+                i = MAP_BLOCK_SIZE - by;
+            }
+            else
+            {
+                pitch = 1;
+                i = MAP_BLOCK_SIZE - bx;
+            }
+
+            if (i > remaining) i = remaining;
+        }
+
+        remaining -= i;
+        if (column) y += i;
+        else x += i;
+
+        while(i--)
+        {
+            *d++ = baseflags | (*src + baseindex);
+            src += pitch;
+        }
+    }
+}
+
+static const u16 *getBlock(MapScroller *scroller, u16 blockX, u16 blockY)
+{
+    const s16 id = (blockY * ((scroller->w + (MAP_BLOCK_SIZE - 1)) / MAP_BLOCK_SIZE)) + blockX;
+    const u16 time = ++scroller->blockTime;
+    u16 oldest;
+    u16 i;
+
+    // already unpacked ?
+    oldest = 0;
+    for(i = 0; i < MAP_BLOCK_CACHE; i++)
+    {
+        if (scroller->blockIds[i] == id)
+        {
+            scroller->blockUse[i] = time;
+            return scroller->blocks + (i * (MAP_BLOCK_SIZE * MAP_BLOCK_SIZE));
+        }
+
+        // find least recently used entry (unsigned difference handles time wrapping)
+        if ((u16) (time - scroller->blockUse[i]) > (u16) (time - scroller->blockUse[oldest]))
+            oldest = i;
+    }
+
+    // unpack block in least recently used entry
+    unpackMapBlock(scroller->map, blockX, blockY, scroller->blocks + (oldest * (MAP_BLOCK_SIZE * MAP_BLOCK_SIZE)));
+    scroller->blockIds[oldest] = id;
+    scroller->blockUse[oldest] = time;
+
+    return scroller->blocks + (oldest * (MAP_BLOCK_SIZE * MAP_BLOCK_SIZE));
+}
+
+static void writeTilemap(u16 addr, const u16 *data, u16 len, u16 step, u16 now)
+{
+    vu32 *plctrl;
+    vu16 *pwdata;
+    const u16 *src;
+    u16 i;
+
+    // use DMA queue (auto increment step is limited to 255), queue full --> send it now
+    if (!now && (step <= 0xFF))
+    {
+        if (DMA_queueDma(DMA_VRAM, (u32) data, addr, len, step)) return;
+    }
+
+    VDP_setAutoInc(2);
+
+    /* point to vdp port */
+    plctrl = (u32 *) GFX_CTRL_PORT;
+    pwdata = (u16 *) GFX_DATA_PORT;
+
+    src = data;
+    i = len;
+
+    // contiguous data
+    if (step == 2)
+    {
+        *plctrl = GFX_WRITE_VRAM_ADDR(addr);
+        while(i--) *pwdata = *src++;
+    }
+    else
+    {
+        while(i--)
+        {
+            *plctrl = GFX_WRITE_VRAM_ADDR(addr);
+            *pwdata = *src++;
+            addr += step;
+        }
+    }
+}
@@ -0,0 +1,170 @@
+#include "config.h"
+#include "types.h"
+
+#include "pal_alloc.h"
+
+#include "vdp.h"
+#include "vdp_pal.h"
+#include "vdp_tile.h"
+#include "sprite_eng.h"
+#include "dma.h"
+#include "kdebug.h"
+
+
+// hardware palette slot
+typedef struct
+{
+    const Palette *palette;
+    u16 refCount;
+    u16 releaseStamp;
+} PalSlot;
+
+
+static PalSlot slots[4];
+// managed slots
+static u16 firstSlot;
+static u16 lastSlot;
+// release counter (used to reassign oldest released slot first)
+static u16 stamp;
+
+// forward
+static u16 isSamePalette(const Palette *pal1, const Palette *pal2);
+
+
+void PAL_init(u16 firstPal, u16 numPal)
+{
+    u16 i;
+
+    firstSlot = firstPal;
+    lastSlot = (firstPal + numPal) - 1;
+    if (lastSlot > PAL3) lastSlot = PAL3;
+    stamp = 0;
+
+    for(i = 0; i < 4; i++)
+    {
+        slots[i].palette = NULL;
+        slots[i].refCount = 0;
+        slots[i].releaseStamp = 0;
+    }
+}
+
+
+s16 PAL_alloc(const Palette *pal)
+{
+    PalSlot *slot;
+    s16 free;
+    u16 index;
+    u16 len;
+    u16 i;
+
+    // already loaded ?
+    for(i = firstSlot; i <= lastSlot; i++)
+    {
+        slot = &slots[i];
+
+        if (slot->palette && isSamePalette(slot->palette, pal))
+        {
+            slot->refCount++;
+            return i;
+        }
+    }
+
+    // find free slot: never used one first, then oldest released
+    free = -1;
+    for(i = firstSlot; i <= lastSlot; i++)
+    {
+        slot = &slots[i];
+
+        if (slot->refCount == 0)
+        {
+            if (slot->palette == NULL)
+            {
+                free = i;
+                break;
+            }
+            if ((free == -1) || ((u16) (stamp - slot->releaseStamp) > (u16) (stamp - slots[free].releaseStamp)))
+                free = i;
+        }
+    }
+
+    if (free == -1)
+    {
+        if (LIB_DEBUG) KDebug_Alert("PAL_alloc failed: no free palette !");
+        return -1;
+    }
+
+    slot = &slots[free];
+    slot->palette = pal;
+    slot->refCount = 1;
+
+    index = pal->index & 0xF;
+    len = pal->length;
+    // palette doesn't fit in slot --> clamp
+    if ((index + len) > 16)
+    {
+        if (LIB_DEBUG) KDebug_Alert("PAL_alloc: palette exceed slot size, clamped !");
+        len = 16 - index;
+    }
+
+    // assignment changed --> upload colors (queue is full --> send them now)
+    index += free << 4;
+    if (!DMA_queueDma(DMA_CRAM, (u32) pal->data, index * 2, len, 2))
+        VDP_setPaletteColors(index, pal->data, len);
+
+    return free;
+}
+
+void PAL_release(u16 numPal)
+{
+    PalSlot *slot = &slots[numPal & 3];
+
+    if (slot->refCount == 0)
+    {
+        if (LIB_DEBUG) KDebug_Alert("PAL_release failed: palette not allocated !");
+        return;
+    }
+
+    // keep palette content, it can be reused without upload
+    if (--slot->refCount == 0) slot->releaseStamp = stamp++;
+}
+
+u16 PAL_getRefCount(u16 numPal)
+{
+    return slots[numPal & 3].refCount;
+}
+
+
+u16 PAL_allocSprite(Sprite *sprite)
+{
+    const s16 numPal = PAL_alloc(sprite->definition->palette);
+
+    if (numPal == -1) return FALSE;
+
+    SPR_setAttribut(sprite, (sprite->attribut & ~TILE_ATTR_PALETTE_MASK) | TILE_ATTR(numPal, 0, 0, 0));
+
+    return TRUE;
+}
+
+void PAL_releaseSprite(Sprite *sprite)
+{
+    PAL_release((sprite->attribut & TILE_ATTR_PALETTE_MASK) >> 13);
+}
+
+
+static u16 isSamePalette(const Palette *pal1, const Palette *pal2)
+{
+    const u16 *src1;
+    const u16 *src2;
+    u16 i;
+
+    if (pal1 == pal2) return TRUE;
+    if (((pal1->index ^ pal2->index) & 0xF) || (pal1->length != pal2->length)) return FALSE;
+
+    src1 = pal1->data;
+    src2 = pal2->data;
+    i = pal1->length;
+    while(i--)
+        if (*src1++ != *src2++) return FALSE;
+
+    return TRUE;
+}
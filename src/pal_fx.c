@@ -0,0 +1,360 @@
+#include "config.h"
+#include "types.h"
+
+#include "pal_fx.h"
+
+#include "vdp.h"
+#include "vdp_pal.h"
+#include "dma.h"
+#include "memory.h"
+#include "sys.h"
+#include "kdebug.h"
+
+
+// flash state
+typedef struct
+{
+    u16 from;
+    u16 to;
+    u16 color;
+    u16 timer;
+} Flash;
+
+
+// shadow palette (what user set)
+static u16 palette[64];
+// palette sent to CRAM (shadow + flash)
+static u16 cram[64];
+// dirty color range (dirtyFrom > dirtyTo means nothing to send)
+static u16 dirtyFrom = 64;
+static u16 dirtyTo = 0;
+
+// running color cycling
+static PaletteCycle *cycles[PFX_MAX_CYCLE];
+static u16 numCycle;
+// running flash
+static Flash flashes[PFX_MAX_FLASH];
+static u16 numFlash;
+
+// raster split
+static u16 splitColors[PFX_MAX_SPLIT_COLOR];
+static u16 splitIndex;
+static u16 splitCount;
+// split colors already sent for this frame
+static vu16 splitDone;
+
+// we don't want to share them
+extern vu32 VIntProcess;
+extern vu32 HIntProcess;
+
+// forward
+static void markDirty(u16 from, u16 to);
+static void rotate(PaletteCycle *cycle);
+
+
+void PFX_init()
+{
+    PFX_end();
+
+    // start from current CRAM content
+    VDP_getPaletteColors(0, palette, 64);
+}
+
+void PFX_end()
+{
+    // restore flashed colors
+    while(numFlash)
+    {
+        const Flash *flash = &flashes[--numFlash];
+
+        markDirty(flash->from, flash->to);
+    }
+
+    PFX_clearSplit();
+    numCycle = 0;
+}
+
+
+u16 PFX_getColor(u16 index)
+{
+    return palette[index];
+}
+
+void PFX_setColor(u16 index, u16 value)
+{
+    // same color --> nothing to do
+    if (palette[index] == value) return;
+
+    palette[index] = value;
+    markDirty(index, index);
+}
+
+void PFX_setColors(u16 index, const u16 *values, u16 count)
+{
+    if (count == 0) return;
+
+    memcpyU16(palette + index, values, count);
+    markDirty(index, (index + count) - 1);
+}
+
+
+u16 PFX_startCycle(PaletteCycle *cycle, u16 from, u16 to, u16 delay, u16 reverse)
+{
+    if (numCycle >= PFX_MAX_CYCLE)
+    {
+        if (LIB_DEBUG) KDebug_Alert("PFX_startCycle failed: too many running color cycling !");
+        return FALSE;
+    }
+
+    cycle->from = from;
+    cycle->to = to;
+    cycle->delay = delay?delay:1;
+    cycle->timer = cycle->delay;
+    cycle->reverse = reverse;
+
+    cycles[numCycle++] = cycle;
+
+    return TRUE;
+}
+
+void PFX_stopCycle(PaletteCycle *cycle)
+{
+    u16 i;
+
+    for(i = 0; i < numCycle; i++)
+    {
+        if (cycles[i] == cycle)
+        {
+            numCycle--;
+            while(i < numCycle)
+            {
+                cycles[i] = cycles[i + 1];
+                i++;
+            }
+            return;
+        }
+    }
+}
+
+
+u16 PFX_flash(u16 from, u16 to, u16 color, u16 duration)
+{
+    Flash *flash;
+
+    if (numFlash >= PFX_MAX_FLASH)
+    {
+        if (LIB_DEBUG) KDebug_Alert("PFX_flash failed: too many running flash !");
+        return FALSE;
+    }
+
+    if (duration == 0) return TRUE;
+
+    flash = &flashes[numFlash];
+    flash->from = from;
+    flash->to = to;
+    flash->color = color;
+    flash->timer = duration;
+
+    // VBlank process read the list
+    SYS_disableInts();
+    numFlash++;
+    SYS_enableInts();
+
+    markDirty(from, to);
+
+    return TRUE;
+}
+
+
+void PFX_setSplit(u16 line, u16 index, const u16 *colors, u16 count)
+{
+    if (count > PFX_MAX_SPLIT_COLOR) count = PFX_MAX_SPLIT_COLOR;
+
+    SYS_disableInts();
+
+    memcpyU16(splitColors, colors, count);
+    splitIndex = index;
+    splitCount = count;
+    // start on next frame
+    splitDone = TRUE;
+
+    VDP_setHIntCounter(line - 1);
+    HIntProcess |= PROCESS_PALFX_TASK;
+    VIntProcess |= PROCESS_PALFX_TASK;
+    VDP_setHInterrupt(1);
+
+    SYS_enableInts();
+}
+
+void PFX_clearSplit()
+{
+    if (splitCount == 0) return;
+
+    SYS_disableInts();
+
+    VDP_setHInterrupt(0);
+    HIntProcess &= ~PROCESS_PALFX_TASK;
+
+    SYS_enableInts();
+
+    // restore shadow colors
+    markDirty(splitIndex, (splitIndex + splitCount) - 1);
+    splitCount = 0;
+}
+
+
+void PFX_update()
+{
+    PaletteCycle **c;
+    Flash *flash;
+    u16 i;
+
+    // color cycling
+    c = cycles;
+    i = numCycle;
+    while(i--)
+    {
+        PaletteCycle *cycle = *c++;
+
+        if (--cycle->timer == 0)
+        {
+            rotate(cycle);
+            cycle->timer = cycle->delay;
+        }
+    }
+
+    // flash
+    flash = flashes;
+    i = 0;
+    while(i < numFlash)
+    {
+        if (--flash->timer == 0)
+        {
+            // restore shadow colors
+            markDirty(flash->from, flash->to);
+
+            // VBlank process read the list
+            SYS_disableInts();
+            numFlash--;
+            *flash = flashes[numFlash];
+            SYS_enableInts();
+        }
+        else
+        {
+            flash++;
+            i++;
+        }
+    }
+}
+
+
+// called at VBlank to send modified colors, returns FALSE when there is nothing more to do (we don't want to share it)
+u16 PFX_doVBlankProcess()
+{
+    u16 from = dirtyFrom;
+    u16 to = dirtyTo;
+
+    // split colors should be restored for top of screen
+    if (splitCount)
+    {
+        if (splitIndex < from) from = splitIndex;
+        if (((splitIndex + splitCount) - 1) > to) to = (splitIndex + splitCount) - 1;
+
+        splitDone = FALSE;
+    }
+
+    if (from <= to)
+    {
+        const u16 len = (to - from) + 1;
+        Flash *flash;
+        u16 i;
+
+        memcpyU16(cram + from, palette + from, len);
+
+        // apply flash
+        flash = flashes;
+        i = numFlash;
+        while(i--)
+        {
+            memsetU16(cram + flash->from, flash->color, (flash->to - flash->from) + 1);
+            flash++;
+        }
+
+        // single CRAM transfer (done in this VBlank), queue full --> send it now
+        if (!DMA_queueDma(DMA_CRAM, (u32) (cram + from), from * 2, len, 2))
+            VDP_setPaletteColors(from, cram + from, len);
+
+        dirtyFrom = 64;
+        dirtyTo = 0;
+    }
+
+    return (splitCount != 0);
+}
+
+// called at HBlank to change split colors (we don't want to share it)
+u16 PFX_doHBlankProcess()
+{
+    if (!splitDone)
+    {
+        vu16 *pw;
+        vu32 *pl;
+        const u16 *src;
+        u16 i;
+
+        pw = (u16 *) GFX_DATA_PORT;
+        pl = (u32 *) GFX_CTRL_PORT;
+
+        // main code can leave any auto increment step (DMA fill / copy, tilemap column...) --> force it
+        *((vu16*) pl) = 0x8F02;
+        // this overwrites VDP address of any CPU transfer in progress (see PFX_setSplit(..))
+        *pl = GFX_WRITE_CRAM_ADDR(splitIndex * 2);
+
+        src = splitColors;
+        i = splitCount;
+        while(i--) *pw = *src++;
+
+        // restore the auto increment step expected by VDP_getAutoInc()
+        *((vu16*) pl) = 0x8F00 | VDP_getAutoInc();
+
+        splitDone = TRUE;
+    }
+
+    return TRUE;
+}
+
+
+static void markDirty(u16 from, u16 to)
+{
+    SYS_disableInts();
+
+    if (from < dirtyFrom) dirtyFrom = from;
+    if (to > dirtyTo) dirtyTo = to;
+    VIntProcess |= PROCESS_PALFX_TASK;
+
+    SYS_enableInts();
+}
+
+static void rotate(PaletteCycle *cycle)
+{
+    u16 *first = palette + cycle->from;
+    u16 *last = palette + cycle->to;
+    u16 *p;
+    u16 tmp;
+
+    // colors move to lower index
+    if (cycle->reverse)
+    {
+        tmp = *first;
+        for(p = first; p < last; p++) p[0] = p[1];
+        *last = tmp;
+    }
+    // colors move to higher index
+    else
+    {
+        tmp = *last;
+        for(p = last; p > first; p--) p[0] = p[-1];
+        *first = tmp;
+    }
+
+    markDirty(cycle->from, cycle->to);
+}
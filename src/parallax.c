@@ -0,0 +1,55 @@
+#include "config.h"
+#include "types.h"
+
+#include "parallax.h"
+
+#include "vdp.h"
+#include "vdp_bg.h"
+#include "maths.h"
+
+
+void PARA_init(Parallax *parallax, VDPPlan plan, const ParallaxBand *bands, u16 numBand)
+{
+    u16 lines;
+    u16 i;
+
+    parallax->plan = plan;
+    parallax->bands = bands;
+    parallax->table = VDP_getHorizontalScrollTable(plan);
+
+    // ignore bands which exceed the scroll table
+    lines = 0;
+    for(i = 0; i < numBand; i++)
+    {
+        if ((lines + bands[i].height) > VDP_SCROLL_H_TABLE_SIZE) break;
+        lines += bands[i].height;
+    }
+
+    parallax->numBand = i;
+
+    VDP_setScrollingMode(HSCROLL_LINE, VDP_getVerticalScrollingMode());
+}
+
+void PARA_update(Parallax *parallax, s16 camX)
+{
+    const ParallaxBand *band;
+    s16 *dst;
+    u16 i;
+
+    band = parallax->bands;
+    dst = parallax->table;
+    i = parallax->numBand;
+
+    while(i--)
+    {
+        // 16x16 --> 32 bits multiplication (single muls instruction)
+        const s16 value = -((((s32) camX) * ((s32) band->speed)) >> FIX16_FRAC_BITS);
+        u16 h = band->height;
+
+        band++;
+
+        while(h--) *dst++ = value;
+    }
+
+    VDP_queueHorizontalScrollTable(parallax->plan);
+}
@@ -8,7 +8,9 @@
 #include "vdp_spr.h"
 #include "dma.h"
 #include "tile_cache.h"
+#include "vram.h"
 #include "memory.h"
+#include "kdebug.h"
 
 
 #define VISIBILITY_ALWAYS_FLAG  0x40000000
@@ -40,11 +42,26 @@ void SPR_init(u16 cacheSize)
     VDPSpriteCache = MEM_alloc(SPRITE_CACHE_SIZE * sizeof(VDPSprite));
 
     size = cacheSize?cacheSize:384;
-    // get start tile index for sprite cache (reserve VRAM area just before system font)
-    index = TILE_FONTINDEX - size;
 
     // init tile cache engine if needed
     TC_init();
+
+    // VRAM manager enabled --> get sprite cache from it
+    if (VRAM_isInitialized())
+    {
+        if (!VRAM_createCache(&tcSprite, size))
+        {
+            if (LIB_DEBUG) KDebug_Alert("SPR_init failed: cannot create sprite cache in VRAM manager !");
+
+            MEM_free(VDPSpriteCache);
+            VDPSpriteCache = NULL;
+        }
+
+        return;
+    }
+
+    // get start tile index for sprite cache (reserve VRAM area just before system font)
+    index = TILE_FONTINDEX - size;
     // and create a tile cache for the sprite
     TC_createCache(&tcSprite, index, size);
 }
@@ -60,7 +77,8 @@ void SPR_end()
         MEM_free(VDPSpriteCache);
         VDPSpriteCache = NULL;
 
-        TC_releaseCache(&tcSprite);
+        // release cache (give back VRAM to the VRAM manager if it was created from it)
+        VRAM_releaseCache(&tcSprite);
     }
 }
 
@@ -69,6 +87,11 @@ u16 SPR_isInitialized()
     return (VDPSpriteCache != NULL);
 }
 
+TileCache* SPR_getTileCache()
+{
+    return &tcSprite;
+}
+
 
 void SPR_initSprite(Sprite *sprite, const SpriteDefinition *spriteDef, s16 x, s16 y, u16 attribut)
 {
@@ -432,6 +455,9 @@ void SPR_update(Sprite *sprites, u16 num)
 
     // send sprites to VRAM using DMA queue
     DMA_queueDma(DMA_VRAM, (u32) VDPSpriteCache, VDP_getSpriteListAddress(), (ind * sizeof(VDPSprite)) / 2, 2);
+
+    // all sprites tile indexes are sent (required by auto defragmentation)
+    TC_endUpdate(&tcSprite);
 }
 
 //void SPR_release(Sprite *sprites, u16 num)
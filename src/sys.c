@@ -37,12 +37,20 @@
 // we don't want to share them
 extern u16 randbase;
 extern TileSet** uploads;
+extern u16 vramInitialized;
 extern s16 currentDriver;
 
 // extern library callback function (we don't want to share them)
 extern u16 BMP_doHBlankProcess();
 extern void BMP_doVBlankProcess();
 extern void TC_doVBlankProcess();
+extern u16 VDP_doVBlankScrollProcess();
+extern void VDP_doVBlankRegProcess();
+extern u16 TMB_doVBlankProcess();
+extern u16 TL_doVBlankProcess();
+extern u16 VDP_doVBlankFadingProcess();
+extern u16 PFX_doVBlankProcess();
+extern u16 PFX_doHBlankProcess();
 extern u16 SPR_doVBlankProcess();
 extern void XGM_doVBlankProcess();
 
@@ -388,6 +396,9 @@ void _vint_callback()
     // call user callback (pre V-Int)
     if (VIntCBPre) VIntCBPre();
 
+    // write queued VDP registers (nothing to do most of time)
+    VDP_doVBlankRegProcess();
+
     vintp = VIntProcess;
     // may worth it
     if (vintp)
@@ -396,6 +407,42 @@ void _vint_callback()
         if (vintp & PROCESS_XGM_TASK)
             XGM_doVBlankProcess();
 
+        // scroll tables processing (queue DMA so it has to be done before DMA processing)
+        if (vintp & PROCESS_SCROLL_TASK)
+        {
+            if (!VDP_doVBlankScrollProcess()) vintp &= ~PROCESS_SCROLL_TASK;
+
+            if (DMA_getAutoFlush()) vintp |= PROCESS_DMA_TASK;
+        }
+        // tilemap buffers processing (queue DMA as well)
+        if (vintp & PROCESS_TILEMAP_TASK)
+        {
+            if (!TMB_doVBlankProcess()) vintp &= ~PROCESS_TILEMAP_TASK;
+
+            if (DMA_getAutoFlush()) vintp |= PROCESS_DMA_TASK;
+        }
+        // progressive tile loading (queue DMA as well)
+        if (vintp & PROCESS_TILELOAD_TASK)
+        {
+            if (!TL_doVBlankProcess()) vintp &= ~PROCESS_TILELOAD_TASK;
+
+            if (DMA_getAutoFlush()) vintp |= PROCESS_DMA_TASK;
+        }
+        // palette fading processing (queue DMA as well)
+        if (vintp & PROCESS_PALETTE_FADING)
+        {
+            if (!VDP_doVBlankFadingProcess()) vintp &= ~PROCESS_PALETTE_FADING;
+
+            if (DMA_getAutoFlush()) vintp |= PROCESS_DMA_TASK;
+        }
+        // palette effects processing (queue DMA as well)
+        if (vintp & PROCESS_PALFX_TASK)
+        {
+            if (!PFX_doVBlankProcess()) vintp &= ~PROCESS_PALFX_TASK;
+
+            if (DMA_getAutoFlush()) vintp |= PROCESS_DMA_TASK;
+        }
+
         // dma processing
         if (vintp & PROCESS_DMA_TASK)
         {
@@ -424,11 +471,6 @@ void _vint_callback()
         // bitmap processing
         if (vintp & PROCESS_BITMAP_TASK)
             BMP_doVBlankProcess();
-        // palette fading processing
-        if (vintp & PROCESS_PALETTE_FADING)
-        {
-            if (!VDP_doStepFading(FALSE)) vintp &= ~PROCESS_PALETTE_FADING;
-        }
 
         VIntProcess = vintp;
     }
@@ -452,6 +494,11 @@ void _hint_callback()
     {
         if (!BMP_doHBlankProcess()) HIntProcess &= ~PROCESS_BITMAP_TASK;
     }
+    // palette split processing
+    if (HIntProcess & PROCESS_PALFX_TASK)
+    {
+        if (!PFX_doHBlankProcess()) HIntProcess &= ~PROCESS_PALFX_TASK;
+    }
 
     // ...
 
@@ -607,6 +654,7 @@ static void internal_reset()
 
     // reset variables which own engine initialization state
     uploads = NULL;
+    vramInitialized = FALSE;
 
     // init part
     MEM_init();
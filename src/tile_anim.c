@@ -0,0 +1,125 @@
+#include "config.h"
+#include "types.h"
+
+#include "tile_anim.h"
+
+#include "vdp.h"
+#include "vdp_tile.h"
+#include "dma.h"
+#include "tools.h"
+#include "kdebug.h"
+
+
+// running animations
+static TileAnimation *animations[TA_MAX_ANIM];
+// number of running animation
+static u16 numAnim;
+
+// forward
+static u16 uploadFrame(TileAnimation *animation);
+
+
+u16 TA_start(TileAnimation *animation, const AnimTiles *anim, u16 index)
+{
+    if (numAnim >= TA_MAX_ANIM)
+    {
+        if (LIB_DEBUG) KDebug_Alert("TA_start failed: too many running animations !");
+        return FALSE;
+    }
+
+    animation->anim = anim;
+    animation->index = index;
+    animation->frame = 0;
+    animation->timer = anim->frames[0].timer;
+    animation->paused = FALSE;
+    // tiles content is unknown
+    animation->loaded = NULL;
+
+    animations[numAnim++] = animation;
+
+    return TRUE;
+}
+
+void TA_stop(TileAnimation *animation)
+{
+    u16 i;
+
+    for(i = 0; i < numAnim; i++)
+    {
+        if (animations[i] == animation)
+        {
+            numAnim--;
+            while(i < numAnim)
+            {
+                animations[i] = animations[i + 1];
+                i++;
+            }
+            return;
+        }
+    }
+}
+
+void TA_setPaused(TileAnimation *animation, u16 value)
+{
+    animation->paused = value;
+}
+
+void TA_setFrame(TileAnimation *animation, u16 frame)
+{
+    const AnimTiles *anim = animation->anim;
+
+    if (frame >= anim->numFrame) frame = 0;
+
+    animation->frame = frame;
+    animation->timer = anim->frames[frame].timer;
+}
+
+void TA_update()
+{
+    TileAnimation **anims = animations;
+    u16 i = numAnim;
+
+    while(i--)
+    {
+        TileAnimation *animation = *anims++;
+
+        // timer = 0 --> frame without automatic animation
+        if (!animation->paused && animation->timer)
+        {
+            // next frame
+            if (--animation->timer == 0)
+            {
+                u16 frame = animation->frame + 1;
+
+                if (frame >= animation->anim->numFrame) frame = 0;
+
+                animation->frame = frame;
+                animation->timer = animation->anim->frames[frame].timer;
+            }
+        }
+
+        // frame data not yet in VRAM ? (identical frames share the same tileset)
+        if (animation->anim->frames[animation->frame].tileset != animation->loaded)
+            uploadFrame(animation);
+    }
+}
+
+
+static u16 uploadFrame(TileAnimation *animation)
+{
+    const AnimTiles *anim = animation->anim;
+    const TileSet *tileset = anim->frames[animation->frame].tileset;
+
+    if (tileset->compression == COMPRESSION_NONE)
+    {
+        // queue full --> retry on next update
+        if (!DMA_queueDma(DMA_VRAM, (u32) tileset->tiles, animation->index * 32, anim->numTile * 16, 2))
+            return FALSE;
+    }
+    // compressed frame can't be queued, unpack and upload now
+    else if (!VDP_loadTileSet(tileset, animation->index, TRUE)) return FALSE;
+
+    animation->loaded = tileset;
+
+    return TRUE;
+}
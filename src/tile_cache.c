@@ -13,6 +13,17 @@
 
 #define DEFAULT_NUM_BLOC    128
 #define MAX_UPLOAD          100
+#define MAX_DEFRAG_MOVE     16
+#define MAX_VRAM_UNPACK     16
+// maximum number of tile unpacked directly in VRAM per VBlank (CPU unpack takes ~1000 cycles per tile)
+#define MAX_VRAM_UNPACK_TILE 8
+
+// unpack buffer size in byte (include space for a few TileSet header)
+#define UNPACK_BUFFER_BYTES ((TC_UNPACK_BUFFER_SIZE * 32) + (8 * sizeof(TileSet)))
+
+#define HASH_EMPTY          0xFFFF
+// TileSet address hash (TileSet structures are word aligned)
+#define HASH(tileset)       ((u16) (((u32) (tileset) >> 1) ^ ((u32) (tileset) >> 8)))
 
 
 /*
@@ -21,9 +32,23 @@
  * Bloc description:
  *
  *  tileset             = address of the stored / cached tileset
- *  index b14-b0        = VRAM position of the tileset
- *  index b15           = currently in use
- *                        If this bit is cleared it means the tileset can be released if needed
+ *  index               = VRAM position of the tileset
+ *  refCount            = number of allocation not yet released (only meaningful for fixed blocs)
+ *  lastUse             = cache time of last allocation
+ *
+ *  Blocs in [0, nextFixed[ are fixed (currently in use), blocs in [nextFixed, nextFlush[ are
+ *  flushed: the tileset is still in VRAM and can be re allocated quickly but it can also be evicted.
+ *  Blocs never overlap in VRAM so a new allocation first searches a region free of any bloc then
+ *  takes the region where the most recently used overlapped flushed bloc is the oldest (LRU) and
+ *  evicts the flushed blocs it overlaps.
+ *
+ * Hash table:
+ *
+ *  Open addressing hash table (linear probing) indexed by HASH(tileset).
+ *  Each entry contains the bloc index of the tileset or HASH_EMPTY.
+ *  It always contains exactly the blocs in [0, nextFlush[ so each time a bloc is moved,
+ *  added or removed from this range the hash table is updated accordingly.
+ *  The table is at least twice as large as the number of bloc so probing remains short.
  *
  * "cache" gives the VRAM tile organization from "cacheStartIndex" for given "cacheSize":
  *
@@ -155,15 +180,29 @@
  */
 
 
-// we don't want to share it
+// we don't want to share them
 extern vu32 VIntProcess;
+extern u16 VRAM_growCache(TileCache *cache, u16 size);
 
 // forward
 static TCBloc* getFixedBloc(TileCache *cache, TileSet *tileset);
 static TCBloc* getBloc(TileCache *cache, TileSet* tileset);
+static u16* getHashEntry(TileCache *cache, TileSet *tileset);
+static void removeHashEntry(TileCache *cache, TileSet *tileset);
+static void swapBloc(TileCache *cache, TCBloc *bloc1, TCBloc *bloc2);
 static u16 findFreeRegion(TileCache *cache, u16 size);
 static u16 getConflictRegion(TileCache *cache, u16 start, u16 end);
 static void releaseFlushable(TileCache *cache, u16 start, u16 end);
+static void removeFlushBloc(TileCache *cache, TCBloc *bloc);
+static TCBloc* getLRUBloc(TileCache *cache);
+static u16 evictLRU(TileCache *cache, u16 size);
+static TCBloc* useBloc(TileCache *cache, TCBloc *bloc);
+static void getFreeInfo(TileCache *cache, u16 *free, u16 *largest);
+static TCBloc* getDefragBloc(TileCache *cache, u16 pos, u16 gapEnd, TCBloc *next);
+static u16 getTopRegion(TileCache *cache, u16 minPos, u16 size, u16 *freedStart, u16 *freedEnd, u16 numFreed);
+static u16 uploadTileSet(TileSet *tileset, u16 index, TCUpload upload);
+static TileSet* allocateUnpackBuffer(u16 numTile);
+static void clearUploads();
 static void addToUploadQueue(TileSet *tileset, u16 index);
 
 // upload cache structure
@@ -171,6 +210,26 @@ TileSet** uploads;            // this variable is specifically cleared in SYS re
 static u16 uploadIndex;
 static u16 uploadDone;
 
+// unpack buffer (bump allocation, reset when uploads are done)
+static u8 *unpackBuffer;
+static u16 unpackBufferPos;
+
+// RLE tilesets to unpack directly in VRAM during VBlank (when unpack buffer is full)
+static TileSet *vramUnpacks[MAX_VRAM_UNPACK];
+static u16 vramUnpackIndexes[MAX_VRAM_UNPACK];
+static u16 numVRamUnpack;
+
+// automatic defragmentation
+static TileCache *defragCache = NULL;
+static u16 defragMaxTile;
+static u16 defragPending;
+// number of defragmentation pass which moved blocs
+static u16 defragPass;
+// defragPass value on last cache flush
+static u16 defragFlushPass;
+// cache user sent indexes obtained after last pass to VDP (new pass can start)
+static u16 defragRefreshed;
+
 
 void TC_init()
 {
@@ -179,9 +238,12 @@ void TC_init()
     {
         // alloc cache structures memory
         uploads = MEM_alloc(MAX_UPLOAD * sizeof(TileSet*));
+        unpackBuffer = MEM_alloc(UNPACK_BUFFER_BYTES);
         // init upload
         uploadIndex = 0;
         uploadDone = FALSE;
+        unpackBufferPos = 0;
+        numVRamUnpack = 0;
 
         // enabled tile cache Int processing
         VIntProcess |= PROCESS_TILECACHE_TASK;
@@ -197,24 +259,14 @@ void TC_end()
         VIntProcess &= ~PROCESS_TILECACHE_TASK;
 
         // release the last uploaded tileset(s)
-        if (uploadDone)
-        {
-            TileSet** tilesets = uploads;
-            u16 i = uploadIndex;
-
-            while(i--)
-            {
-                TileSet* tileset = *tilesets++;
-
-                // released the tileset if we unpacked it here
-                if (tileset->compression != COMPRESSION_NONE)
-                    MEM_free(tileset);
-            }
-        }
+        clearUploads();
 
         // release cache structures memory
+        MEM_free(unpackBuffer);
         MEM_free(uploads);
         uploads = NULL;
+        // disable auto defragmentation
+        defragCache = NULL;
     }
 }
 
@@ -225,6 +277,8 @@ void TC_createCache(TileCache *cache, u16 startIndex, u16 size)
 
 void TC_createCacheEx(TileCache *cache, u16 startIndex, u16 size, u16 numBloc)
 {
+    u16 hashSize;
+
     cache->startIndex = startIndex;
     cache->limit = startIndex + size;
 
@@ -232,12 +286,22 @@ void TC_createCacheEx(TileCache *cache, u16 startIndex, u16 size, u16 numBloc)
     cache->numBloc = numBloc;
     cache->blocs = MEM_alloc(numBloc * sizeof(TCBloc));
 
+    // hash table size is the first power of 2 >= (2 * numBloc)
+    hashSize = 2;
+    while(hashSize < (numBloc * 2)) hashSize <<= 1;
+    cache->hashMask = hashSize - 1;
+    cache->hashTable = MEM_alloc(hashSize * sizeof(u16));
+
     TC_clearCache(cache);
 }
 
 void TC_releaseCache(TileCache *cache)
 {
+    // disable auto defragmentation for this cache
+    if (defragCache == cache) defragCache = NULL;
+
     // release cache memory
+    MEM_free(cache->hashTable);
     MEM_free(cache->blocs);
 }
 
@@ -247,12 +311,26 @@ void TC_clearCache(TileCache *cache)
     cache->nextFixed = 0;
     cache->nextFlush = 0;
     cache->current = cache->startIndex;
-
+    cache->time = 0;
+    // clear hash table
+    memsetU16(cache->hashTable, HASH_EMPTY, cache->hashMask + 1);
 }
 void TC_flushCache(TileCache *cache)
 {
     // just remove fixed blocs
     cache->nextFixed = 0;
+    // and start a new period for LRU
+    cache->time++;
+
+    // new cache update started
+    if (cache == defragCache) defragFlushPass = defragPass;
+}
+
+void TC_endUpdate(TileCache *cache)
+{
+    // all indexes of this update were obtained after last defragmentation pass ? --> we can start a new one
+    if ((cache == defragCache) && (defragFlushPass == defragPass))
+        defragRefreshed = TRUE;
 }
 
 
@@ -267,121 +345,81 @@ s16 TC_alloc(TileCache *cache, TileSet *tileset, TCUpload upload)
 
     // bloc found
     if (bloc != NULL)
+        return useBloc(cache, bloc)->index;
+    // bloc not found --> alloc
+    else
     {
-        // get address of next fixed bloc
-        u16 nextFixed = cache->nextFixed;
-        TCBloc *nextFixedBloc = &cache->blocs[nextFixed];
+        u16 index, size;
+        u16 nextFlush;
 
-        // flushed bloc ? --> re allocate it
-        if (bloc >= nextFixedBloc)
+        // no more free bloc ?
+        if (cache->nextFlush >= cache->numBloc)
         {
-            // need to swap blocs ?
-            if (bloc != nextFixedBloc)
-            {
-                u16 tmpInd = bloc->index;
-                bloc->index = nextFixedBloc->index;
-                bloc->tileset = nextFixedBloc->tileset;
-                nextFixedBloc->index = tmpInd;
-                nextFixedBloc->tileset = tileset;
+            // evict the least recently used flushed bloc
+            TCBloc *lru = getLRUBloc(cache);
 
-                bloc = nextFixedBloc;
+            if (lru == NULL)
+            {
+                if (LIB_DEBUG) KDebug_Alert("TC_alloc failed: no more free bloc !");
+                return -1;
             }
 
-            // one more fixed bloc
-            cache->nextFixed = nextFixed + 1;
+            removeFlushBloc(cache, lru);
         }
 
-        return bloc->index;
-    }
-    // bloc not found --> alloc
-    else
-    {
-        u16 index, size, lim;
-        u16 nextFlush;
+        size = tileset->numTile;
+        // search for region free of any bloc (this method can consume a lot of time :-/)
+        index = findFreeRegion(cache, size);
 
-        // not more free bloc
-        if (cache->nextFixed >= cache->numBloc)
+        // not found --> evict least recently used flushed blocs
+        if ((s16) index == -1)
         {
-            if (LIB_DEBUG) KDebug_Alert("TC_alloc failed: no more free bloc !");
-            return -1;
+            index = evictLRU(cache, size);
+            // cache is getting fragmented
+            if (cache == defragCache) defragPending = TRUE;
         }
 
-        size = tileset->numTile;
-        // search for free region (this method can consume a lot of time :-/)
-        index = findFreeRegion(cache, size);
+        // not enough space in cache --> try to get more VRAM from VRAM manager
+        if (((s16) index == -1) && VRAM_growCache(cache, size))
+            index = findFreeRegion(cache, size);
 
         // not enough space in cache
         if ((s16) index == -1)
-            return index;
-
-        // process VDP upload if required
-        if (upload != NO_UPLOAD)
         {
-            // no compression
-            if (tileset->compression == COMPRESSION_NONE)
-            {
-                // upload the tileset to VRAM now
-                if (upload == UPLOAD_NOW) VDP_loadTileData(tileset->tiles, index, size, TRUE);
-                // upload at VINT
-                else addToUploadQueue(tileset, index);
-            }
-            else
-            {
-                // unpack tileset
-                TileSet *unpacked = unpackTileSet(tileset, NULL);
-
-                // error while unpacking tileset
-                if (unpacked == NULL)
-                    return -1;
-
-                // upload the tileset to VRAM now ?
-                if (upload == UPLOAD_NOW)
-                {
-                    // upload
-                     VDP_loadTileData(unpacked->tiles, index, size, TRUE);
-                     // and release memory
-                     MEM_free(unpacked);
-                }
-                // upload at VINT
-                else
-                {
-                    // we will use that to release automatically the TileSet after upload
-                    unpacked->compression = COMPRESSION_APLIB;
-                    // put in upload queue
-                    addToUploadQueue(unpacked, index);
-                }
-            }
+            if (LIB_DEBUG) KDebug_Alert("TC_alloc failed: no enough available VRAM in cache !");
+            return index;
         }
 
-        lim = index + size;
+        // process VDP upload if required (error while unpacking tileset ?)
+        if ((upload != NO_UPLOAD) && !uploadTileSet(tileset, index, upload))
+            return -1;
+
         // update current position
-        cache->current = lim;
-        // release any previous flushable bloc in the allocated area
-        releaseFlushable(cache, index, lim);
+        cache->current = index + size;
 
         // get new allocated bloc
         bloc = &cache->blocs[cache->nextFixed++];
 
-        // try to save flush bloc if we still have available bloc for that ?
+        // bloc position used by a flushed bloc ? --> move it at end of flushed blocs
         nextFlush = cache->nextFlush;
-        if (nextFlush < cache->numBloc)
+        if (bloc != &cache->blocs[nextFlush])
         {
-            TCBloc *nextFlushBloc = &cache->blocs[nextFlush];
-
-            // test if we have something to save
-            if (nextFlushBloc != bloc)
-            {
-                nextFlushBloc->index = bloc->index;
-                nextFlushBloc->tileset = bloc->tileset;
-            }
+            // get hash entry before moving bloc
+            u16 *entry = getHashEntry(cache, bloc->tileset);
 
-            // increase flush bloc address
-            cache->nextFlush = nextFlush + 1;
+            cache->blocs[nextFlush] = *bloc;
+            *entry = nextFlush;
         }
 
+        // increase flush bloc address (we always have a free bloc here)
+        cache->nextFlush = nextFlush + 1;
+
         // set bloc info
         bloc->tileset = tileset;
         bloc->index = index;
+        bloc->refCount = 1;
+        bloc->lastUse = cache->time;
+        *getHashEntry(cache, tileset) = bloc - cache->blocs;
     }
 
     return bloc->index;
@@ -395,32 +433,7 @@ s16 TC_reAlloc(TileCache *cache, TileSet *tileset)
 
     // bloc found
     if (bloc != NULL)
-    {
-        // get address of next fixed bloc
-        u16 nextFixed = cache->nextFixed;
-        TCBloc *nextFixedBloc = &cache->blocs[nextFixed];
-
-        // flushed bloc ? --> re allocate it
-        if (bloc >= nextFixedBloc)
-        {
-            // need to swap blocs ?
-            if (bloc != nextFixedBloc)
-            {
-                u16 tmpInd = bloc->index;
-                bloc->index = nextFixedBloc->index;
-                bloc->tileset = nextFixedBloc->tileset;
-                nextFixedBloc->index = tmpInd;
-                nextFixedBloc->tileset = tileset;
-
-                bloc = nextFixedBloc;
-            }
-
-            // one more fixed bloc
-            cache->nextFixed = nextFixed + 1;
-        }
-
-        return bloc->index;
-    }
+        return useBloc(cache, bloc)->index;
 
     return -1;
 }
@@ -430,24 +443,16 @@ void TC_free(TileCache *cache, TileSet *tileset)
     // find allocated bloc
     TCBloc *bloc = getFixedBloc(cache, tileset);
 
-    // bloc found
-    if (bloc != NULL)
+    // bloc found and not referenced anymore ?
+    if ((bloc != NULL) && (--bloc->refCount == 0))
     {
         // get last fixed bloc and decrease number of fixed bloc
         TCBloc *lastFixedBloc = &cache->blocs[--cache->nextFixed];
 
-        // exchange bloc infos if needed
-        if (lastFixedBloc != bloc)
-        {
-            u16 tmpInd = bloc->index;
-            bloc->index = lastFixedBloc->index;
-            bloc->tileset = lastFixedBloc->tileset;
-            lastFixedBloc->index = tmpInd;
-            lastFixedBloc->tileset = tileset;
-        }
+        bloc->lastUse = cache->time;
 
-        // decrease flush bloc address
-        cache->nextFlush--;
+        // exchange bloc infos if needed (bloc become the first flushed bloc and remains in cache)
+        if (lastFixedBloc != bloc) swapBloc(cache, bloc, lastFixedBloc);
     }
 }
 
@@ -461,66 +466,298 @@ s16 TC_getTileIndex(TileCache *cache, TileSet *tileset)
     return -1;
 }
 
-void TC_uploadAtVBlank(TileSet *tileset, u16 index)
+u16 TC_setRegion(TileCache *cache, u16 startIndex, u16 size)
 {
-    TileSet *unpacked;
+    const u16 limit = startIndex + size;
+    TCBloc *bloc;
+    u16 i;
 
-    if (tileset->compression == COMPRESSION_NONE) unpacked = tileset;
-    else
+    // check that all fixed blocs fit in the new region
+    i = cache->nextFixed;
+    bloc = cache->blocs;
+    while(i--)
     {
-        unpacked = unpackTileSet(tileset, NULL);
+        const u16 index = bloc->index;
 
-        // error while unpacking tileset
-        if (unpacked == NULL)
-            return;
+        if ((index < startIndex) || ((index + bloc->tileset->numTile) > limit))
+            return FALSE;
 
-        // we will use that to release automatically the TileSet after upload
-        unpacked->compression = COMPRESSION_APLIB;
+        bloc++;
+    }
+
+    // release flushable blocs outside the new region
+    releaseFlushable(cache, 0, startIndex);
+    releaseFlushable(cache, limit, 0xFFFF);
+
+    cache->startIndex = startIndex;
+    cache->limit = limit;
+    // current position out of region ? --> reset it
+    if ((cache->current < startIndex) || (cache->current >= limit))
+        cache->current = startIndex;
+
+    return TRUE;
+}
+
+u16 TC_defrag(TileCache *cache, u16 maxTile)
+{
+    // VRAM regions released during this pass (can still be used by current displayed frame)
+    u16 freedStart[MAX_DEFRAG_MOVE];
+    u16 freedEnd[MAX_DEFRAG_MOVE];
+    const u16 lim = cache->limit;
+    u16 numMove;
+    u16 moved;
+    u16 pos;
+
+    numMove = 0;
+    moved = 0;
+    pos = cache->startIndex;
+
+    while(numMove < MAX_DEFRAG_MOVE)
+    {
+        TCBloc *bloc;
+        TCBloc *next;
+        u16 gapEnd;
+        u16 src, dst, size;
+        u16 i;
+
+        // position in a region released in this pass ? --> skip it (released regions can be contiguous)
+        i = 0;
+        while(i < numMove)
+        {
+            if ((pos >= freedStart[i]) && (pos < freedEnd[i]))
+            {
+                pos = freedEnd[i];
+                i = 0;
+            }
+            else i++;
+        }
+        if (pos >= lim) break;
+
+        // find end of free region (flushed blocs are considered as free)
+        gapEnd = lim;
+        next = NULL;
+        i = cache->nextFixed;
+        bloc = cache->blocs;
+        while(i--)
+        {
+            const u16 index = bloc->index;
+
+            if ((index >= pos) && (index < gapEnd))
+            {
+                gapEnd = index;
+                next = bloc;
+            }
+
+            bloc++;
+        }
+        for(i = 0; i < numMove; i++)
+        {
+            if ((freedStart[i] >= pos) && (freedStart[i] < gapEnd))
+            {
+                gapEnd = freedStart[i];
+                next = NULL;
+            }
+        }
+
+        // allocated bloc at current position --> pass it
+        if (gapEnd == pos)
+        {
+            pos += next->tileset->numTile;
+            continue;
+        }
+        // only free space remaining --> done
+        if ((next == NULL) && (gapEnd == lim)) break;
+
+        // find a bloc to move in the free region
+        bloc = getDefragBloc(cache, pos, gapEnd, next);
+
+        if (bloc != NULL) dst = pos;
+        // nothing fit and region is followed by a bloc ?
+        else if (next != NULL)
+        {
+            // move the bloc to the top of the cache so the free region will merge with its location on next pass
+            bloc = next;
+            dst = getTopRegion(cache, next->index + next->tileset->numTile, next->tileset->numTile, freedStart, freedEnd, numMove);
+            // not possible
+            if (dst == (u16) -1) bloc = NULL;
+        }
+
+        // nothing to do --> pass the region
+        if (bloc == NULL)
+        {
+            pos = gapEnd;
+            continue;
+        }
+
+        src = bloc->index;
+        size = bloc->tileset->numTile;
+
+        // no more budget
+        if ((moved + size) > maxTile) break;
+
+        // evict flushed blocs in destination region
+        releaseFlushable(cache, dst, dst + size);
+
+        // move bloc
+        VDP_waitDMACompletion();
+        DMA_doVRamCopy(src * 32, dst * 32, size * 32);
+        bloc->index = dst;
+
+        // store released region
+        freedStart[numMove] = src;
+        freedEnd[numMove] = src + size;
+        numMove++;
+
+        moved += size;
+        // bloc moved in free region ? --> continue after it
+        if (dst == pos) pos += size;
     }
 
-    // add to upload queue
-    addToUploadQueue(unpacked, index);
+    // wait for last copy and restore default auto increment
+    if (moved)
+    {
+        VDP_waitDMACompletion();
+        VDP_setAutoInc(2);
+    }
+
+    return moved;
+}
+
+void TC_setAutoDefrag(TileCache *cache, u16 maxTilePerFrame)
+{
+    defragCache = cache;
+    defragMaxTile = maxTilePerFrame;
+    defragPending = FALSE;
+    // no pass done yet so current indexes are safe
+    defragFlushPass = defragPass;
+    defragRefreshed = TRUE;
+}
+
+u16 TC_getFreeTile(TileCache *cache)
+{
+    u16 free, largest;
+
+    getFreeInfo(cache, &free, &largest);
+
+    return free;
+}
+
+u16 TC_getLargestFreeRegion(TileCache *cache)
+{
+    u16 free, largest;
+
+    getFreeInfo(cache, &free, &largest);
+
+    return largest;
+}
+
+void TC_uploadAtVBlank(TileSet *tileset, u16 index)
+{
+    uploadTileSet(tileset, index, UPLOAD_VINT);
 }
 
 
 static TCBloc* getFixedBloc(TileCache *cache, TileSet *tileset)
 {
-    TCBloc *bloc;
-    u16 i;
+    const u16 ind = *getHashEntry(cache, tileset);
 
     // search in fixed blocs only
-    i = cache->nextFixed;
-    bloc = cache->blocs;
-    while(i--)
-    {
-        // found
-        if (bloc->tileset == tileset)
-            return bloc;
-
-        bloc++;
-    }
+    if (ind < cache->nextFixed)
+        return &cache->blocs[ind];
 
     return NULL;
 }
 
 static TCBloc* getBloc(TileCache *cache, TileSet *tileset)
 {
-    TCBloc *bloc;
-    u16 i;
+    const u16 ind = *getHashEntry(cache, tileset);
 
-    // search in fixed & flushable blocs
-    i = cache->nextFlush;
-    bloc = cache->blocs;
-    while(i--)
+    // search in fixed & flushable blocs (hash table only contains them)
+    if (ind != HASH_EMPTY)
+        return &cache->blocs[ind];
+
+    return NULL;
+}
+
+static u16* getHashEntry(TileCache *cache, TileSet *tileset)
+{
+    const TCBloc *blocs = cache->blocs;
+    u16 *table = cache->hashTable;
+    const u16 mask = cache->hashMask;
+    u16 h = HASH(tileset) & mask;
+
+    // linear probing (table is never full so we always meet an empty entry)
+    while(TRUE)
     {
-        // found
-        if (bloc->tileset == tileset)
-            return bloc;
+        u16 *entry = &table[h];
+        const u16 ind = *entry;
 
-        bloc++;
+        // found or free entry
+        if ((ind == HASH_EMPTY) || (blocs[ind].tileset == tileset))
+            return entry;
+
+        h = (h + 1) & mask;
     }
+}
 
-    return NULL;
+static void removeHashEntry(TileCache *cache, TileSet *tileset)
+{
+    const TCBloc *blocs = cache->blocs;
+    u16 *table = cache->hashTable;
+    const u16 mask = cache->hashMask;
+    u16 *entry;
+    u16 i, j;
+
+    entry = getHashEntry(cache, tileset);
+    // not found
+    if (*entry == HASH_EMPTY) return;
+
+    // backward shift deletion so we don't need tombstone
+    i = entry - table;
+    j = i;
+    while(TRUE)
+    {
+        u16 ind;
+        u16 h;
+
+        j = (j + 1) & mask;
+        ind = table[j];
+
+        // end of cluster
+        if (ind == HASH_EMPTY) break;
+
+        // get original position of this entry
+        h = HASH(blocs[ind].tileset) & mask;
+
+        // entry can't be moved in the hole if its position is cyclically in ]i, j]
+        if (i <= j)
+        {
+            if ((i < h) && (h <= j)) continue;
+        }
+        else if ((i < h) || (h <= j)) continue;
+
+        // move entry in the hole
+        table[i] = ind;
+        i = j;
+    }
+
+    table[i] = HASH_EMPTY;
+}
+
+static void swapBloc(TileCache *cache, TCBloc *bloc1, TCBloc *bloc2)
+{
+    TCBloc *blocs = cache->blocs;
+    // get hash entries before swapping blocs
+    u16 *entry1 = getHashEntry(cache, bloc1->tileset);
+    u16 *entry2 = getHashEntry(cache, bloc2->tileset);
+    TCBloc tmp = *bloc1;
+
+    *bloc1 = *bloc2;
+    *bloc2 = tmp;
+
+    // update hash table
+    *entry1 = bloc2 - blocs;
+    *entry2 = bloc1 - blocs;
 }
 
 static u16 findFreeRegion(TileCache *cache, u16 size)
@@ -533,7 +770,7 @@ static u16 findFreeRegion(TileCache *cache, u16 size)
     end = start + size;
 
     // search for a free region
-    while(end < lim)
+    while(end <= lim)
     {
         u16 pos = getConflictRegion(cache, start, end);
 
@@ -544,13 +781,14 @@ static u16 findFreeRegion(TileCache *cache, u16 size)
         end = start + size;
     }
 
-    // restart from begining
-    lim = cache->current;
+    // restart from begining (up to regions overlapping current position)
+    lim = cache->current + (size - 1);
+    if (lim > cache->limit) lim = cache->limit;
     start = cache->startIndex;
     end = start + size;
 
     // search for a free region
-    while(end < lim)
+    while(end <= lim)
     {
         u16 pos = getConflictRegion(cache, start, end);
 
@@ -561,8 +799,6 @@ static u16 findFreeRegion(TileCache *cache, u16 size)
         end = start + size;
     }
 
-    if (LIB_DEBUG) KDebug_Alert("TC_alloc failed: no enough available VRAM in cache !");
-
     return (u16) -1;
 }
 
@@ -571,8 +807,8 @@ static u16 getConflictRegion(TileCache *cache, u16 start, u16 end)
     TCBloc *bloc;
     u16 i;
 
-    // search only in fixed blocs
-    i = cache->nextFixed;
+    // search in fixed & flushed blocs
+    i = cache->nextFlush;
     bloc = cache->blocs;
 
     while(i--)
@@ -594,42 +830,399 @@ static u16 getConflictRegion(TileCache *cache, u16 start, u16 end)
 static void releaseFlushable(TileCache *cache, u16 start, u16 end)
 {
     TCBloc *bloc;
-    u16 lastFlushInd;
     u16 i;
 
-    lastFlushInd = cache->nextFlush;
-
-    // search only in flushable blocs and from end
-    i = lastFlushInd - cache->nextFixed;
-    bloc = &(cache->blocs[lastFlushInd - 1]);
+    // search only in flushable blocs and from end (so moved blocs are already tested)
+    i = cache->nextFlush - cache->nextFixed;
+    bloc = &(cache->blocs[cache->nextFlush - 1]);
     while(i--)
     {
         u16 index = bloc->index;
 
         // need to release bloc ?
         if ((index < end) && ((index + bloc->tileset->numTile) > start))
+            removeFlushBloc(cache, bloc);
+
+        --bloc;
+    }
+}
+
+static void removeFlushBloc(TileCache *cache, TCBloc *bloc)
+{
+    // get last flushed bloc and decrease flush bloc address
+    TCBloc *lastFlushBloc = &(cache->blocs[--cache->nextFlush]);
+
+    // remove released bloc from hash table
+    removeHashEntry(cache, bloc->tileset);
+
+    // save last flush bloc data in the released bloc
+    if (bloc != lastFlushBloc)
+    {
+        // get hash entry before moving bloc
+        u16 *entry = getHashEntry(cache, lastFlushBloc->tileset);
+
+        *bloc = *lastFlushBloc;
+        *entry = bloc - cache->blocs;
+    }
+}
+
+static TCBloc* getLRUBloc(TileCache *cache)
+{
+    const u16 time = cache->time;
+    TCBloc *bloc;
+    TCBloc *result;
+    u16 maxAge;
+    u16 i;
+
+    result = NULL;
+    maxAge = 0;
+
+    // search only in flushed blocs
+    i = cache->nextFlush - cache->nextFixed;
+    bloc = &(cache->blocs[cache->nextFixed]);
+    while(i--)
+    {
+        // age computation is safe with time wrapping
+        const u16 age = time - bloc->lastUse;
+
+        if ((result == NULL) || (age > maxAge))
+        {
+            result = bloc;
+            maxAge = age;
+        }
+
+        bloc++;
+    }
+
+    return result;
+}
+
+static u16 evictLRU(TileCache *cache, u16 size)
+{
+    const u16 time = cache->time;
+    const u16 nextFixed = cache->nextFixed;
+    const u16 numBloc = cache->nextFlush;
+    const u16 lim = cache->limit;
+    TCBloc *candidate;
+    u16 best, bestAge;
+    u16 start;
+    u16 c;
+
+    best = (u16) -1;
+    bestAge = 0;
+
+    // candidate regions start at cache start or just after a bloc (this method can consume a lot of time :-/)
+    start = cache->startIndex;
+    candidate = cache->blocs;
+    c = numBloc + 1;
+    while(c--)
+    {
+        const u16 end = start + size;
+
+        if (end <= lim)
+        {
+            TCBloc *bloc;
+            u16 minAge;
+            u16 i;
+
+            // minimum age of flushed blocs overlapping region
+            minAge = 0xFFFF;
+            bloc = cache->blocs;
+            for(i = 0; i < numBloc; i++, bloc++)
+            {
+                const u16 startBloc = bloc->index;
+
+                // overlap ?
+                if ((startBloc < end) && ((startBloc + bloc->tileset->numTile) > start))
+                {
+                    // fixed bloc --> region not available
+                    if (i < nextFixed) break;
+                    else
+                    {
+                        // age computation is safe with time wrapping
+                        const u16 age = time - bloc->lastUse;
+
+                        if (age < minAge) minAge = age;
+                    }
+                }
+            }
+
+            // region available and its most recently used bloc is older than best region one ?
+            if ((i == numBloc) && ((best == (u16) -1) || (minAge > bestAge)))
+            {
+                best = start;
+                bestAge = minAge;
+            }
+        }
+
+        // next candidate
+        if (c)
         {
-            // get last bloc location
-            TCBloc *lastFlushBloc = &(cache->blocs[--lastFlushInd]);
+            start = candidate->index + candidate->tileset->numTile;
+            candidate++;
+        }
+    }
+
+    // evict flushed blocs in the region
+    if (best != (u16) -1)
+        releaseFlushable(cache, best, best + size);
+
+    return best;
+}
+
+static TCBloc* useBloc(TileCache *cache, TCBloc *bloc)
+{
+    // get address of next fixed bloc
+    const u16 nextFixed = cache->nextFixed;
+    TCBloc *nextFixedBloc = &cache->blocs[nextFixed];
+
+    // flushed bloc ? --> re allocate it
+    if (bloc >= nextFixedBloc)
+    {
+        // need to swap blocs ?
+        if (bloc != nextFixedBloc)
+        {
+            swapBloc(cache, bloc, nextFixedBloc);
+            bloc = nextFixedBloc;
+        }
+
+        // one more fixed bloc
+        cache->nextFixed = nextFixed + 1;
+        bloc->refCount = 1;
+    }
+    // already allocated --> one more reference
+    else bloc->refCount++;
+
+    bloc->lastUse = cache->time;
 
-            // save last flush bloc data in the new released bloc to release last bloc
-            if (bloc != lastFlushBloc)
+    return bloc;
+}
+
+static void getFreeInfo(TileCache *cache, u16 *free, u16 *largest)
+{
+    const u16 lim = cache->limit;
+    u16 pos;
+    u16 f, l;
+
+    f = 0;
+    l = 0;
+    pos = cache->startIndex;
+
+    // walk through fixed blocs in VRAM order (this method can consume a lot of time)
+    while(pos < lim)
+    {
+        TCBloc *bloc;
+        u16 nextStart, nextEnd;
+        u16 i;
+
+        nextStart = lim;
+        nextEnd = lim;
+
+        // find first fixed bloc ending after current position
+        i = cache->nextFixed;
+        bloc = cache->blocs;
+        while(i--)
+        {
+            const u16 startBloc = bloc->index;
+            const u16 endBloc = startBloc + bloc->tileset->numTile;
+
+            if ((endBloc > pos) && (startBloc < nextStart))
             {
-                bloc->tileset = lastFlushBloc->tileset;
-                bloc->index = lastFlushBloc->index;
+                nextStart = startBloc;
+                nextEnd = endBloc;
             }
+
+            bloc++;
         }
 
-        --bloc;
+        // free region before this bloc ?
+        if (nextStart > pos)
+        {
+            const u16 size = nextStart - pos;
+
+            f += size;
+            if (size > l) l = size;
+        }
+
+        pos = nextEnd;
     }
 
-    // update first flushable bloc index
-    cache->nextFlush = lastFlushInd;
+    *free = f;
+    *largest = l;
 }
 
-static void addToUploadQueue(TileSet *tileset, u16 index)
+static TCBloc* getDefragBloc(TileCache *cache, u16 pos, u16 gapEnd, TCBloc *next)
 {
-    // need to clear to queue ?
+    const u16 size = gapEnd - pos;
+    TCBloc *bloc;
+    TCBloc *result;
+    u16 i;
+
+    // next bloc fit in the free region (no overlap) --> just move it down
+    if ((next != NULL) && (next->tileset->numTile <= size))
+        return next;
+
+    // otherwise take the highest bloc which fit in the free region
+    result = NULL;
+    i = cache->nextFixed;
+    bloc = cache->blocs;
+    while(i--)
+    {
+        if ((bloc->index > gapEnd) && (bloc->tileset->numTile <= size))
+        {
+            if ((result == NULL) || (bloc->index > result->index))
+                result = bloc;
+        }
+
+        bloc++;
+    }
+
+    return result;
+}
+
+static u16 getTopRegion(TileCache *cache, u16 minPos, u16 size, u16 *freedStart, u16 *freedEnd, u16 numFreed)
+{
+    const u16 numFixed = cache->nextFixed;
+    u16 result;
+    u16 c;
+
+    result = (u16) -1;
+
+    // candidate regions end at cache limit or just before a fixed bloc or a released region
+    c = numFixed + numFreed + 1;
+    while(c--)
+    {
+        u16 end, start;
+        u16 i;
+
+        if (c < numFixed) end = cache->blocs[c].index;
+        else if (c < (numFixed + numFreed)) end = freedStart[c - numFixed];
+        else end = cache->limit;
+
+        // can't fit or lower than current result
+        if (end < (minPos + size)) continue;
+        start = end - size;
+        if ((result != (u16) -1) && (start <= result)) continue;
+
+        // test conflict with fixed blocs
+        for(i = 0; i < numFixed; i++)
+        {
+            const TCBloc *bloc = &cache->blocs[i];
+            const u16 startBloc = bloc->index;
+
+            if ((startBloc < end) && ((startBloc + bloc->tileset->numTile) > start)) break;
+        }
+        if (i < numFixed) continue;
+
+        // test conflict with released regions
+        for(i = 0; i < numFreed; i++)
+            if ((freedStart[i] < end) && (freedEnd[i] > start)) break;
+        if (i < numFreed) continue;
+
+        result = start;
+    }
+
+    return result;
+}
+
+static u16 uploadTileSet(TileSet *tileset, u16 index, TCUpload upload)
+{
+    const u16 compression = tileset->compression;
+    const u16 numTile = tileset->numTile;
+    TileSet *unpacked;
+
+    // no compression
+    if (compression == COMPRESSION_NONE)
+    {
+        // upload the tileset to VRAM now
+        if (upload == UPLOAD_NOW) VDP_loadTileData(tileset->tiles, index, numTile, TRUE);
+        // upload at VINT
+        else addToUploadQueue(tileset, index);
+
+        return TRUE;
+    }
+
+    // RLE tileset to upload now --> unpack directly in VRAM
+    if ((upload == UPLOAD_NOW) && (compression == COMPRESSION_RLE))
+    {
+        rle4b_unpackVRam((u8*) tileset->tiles, index * 32, 0, 0);
+        return TRUE;
+    }
+
+    // previous uploads done ? --> release unpack buffer
+    clearUploads();
+
+    // try to unpack in unpack buffer
+    unpacked = allocateUnpackBuffer(numTile);
+
+    if (unpacked != NULL) unpackTileSet(tileset, unpacked);
+    else
+    {
+        // RLE tileset --> unpack it directly in VRAM during VBlank
+        if ((compression == COMPRESSION_RLE) && (numVRamUnpack < MAX_VRAM_UNPACK))
+        {
+            // VBlank process read and update the list
+            SYS_disableInts();
+            vramUnpacks[numVRamUnpack] = tileset;
+            vramUnpackIndexes[numVRamUnpack] = index;
+            numVRamUnpack++;
+            SYS_enableInts();
+
+            return TRUE;
+        }
+
+        // unpack buffer is full --> use temporary allocated tileset
+        unpacked = unpackTileSet(tileset, NULL);
+
+        // error while unpacking tileset
+        if (unpacked == NULL)
+            return FALSE;
+
+        // we will use that to release automatically the TileSet after upload
+        unpacked->compression = COMPRESSION_APLIB;
+    }
+
+    // upload the tileset to VRAM now ?
+    if (upload == UPLOAD_NOW)
+    {
+        // upload
+        VDP_loadTileData(unpacked->tiles, index, numTile, TRUE);
+
+        // and release memory
+        if (unpacked->compression != COMPRESSION_NONE) MEM_free(unpacked);
+        // allocated in unpack buffer --> release it (last allocated)
+        else unpackBufferPos -= sizeof(TileSet) + (numTile * 32);
+    }
+    // upload at VINT
+    else addToUploadQueue(unpacked, index);
+
+    return TRUE;
+}
+
+static TileSet* allocateUnpackBuffer(u16 numTile)
+{
+    // u32 as large tileset (> 2047 tiles) would overflow a u16 size
+    const u32 size = sizeof(TileSet) + (((u32) numTile) * 32);
+    TileSet *result;
+
+    // not enough space (caller falls back on VRAM unpack or temporary buffer)
+    if ((unpackBufferPos + size) > UNPACK_BUFFER_BYTES)
+        return NULL;
+
+    result = (TileSet*) &unpackBuffer[unpackBufferPos];
+    unpackBufferPos += size;
+
+    // unpacked tileset are not compressed (so they won't be released)
+    result->compression = COMPRESSION_NONE;
+    result->numTile = numTile;
+    result->tiles = (u32*) &result[1];
+
+    return result;
+}
+
+static void clearUploads()
+{
+    // uploads done ?
     if (uploadDone)
     {
         TileSet** tilesets = uploads;
@@ -647,7 +1240,15 @@ static void addToUploadQueue(TileSet *tileset, u16 index)
         // prepare for new upload
         uploadDone = FALSE;
         uploadIndex = 0;
+        // release unpack buffer
+        unpackBufferPos = 0;
     }
+}
+
+static void addToUploadQueue(TileSet *tileset, u16 index)
+{
+    // need to clear the queue ?
+    clearUploads();
 
     // set upload tileset info
     uploads[uploadIndex++] = tileset;
@@ -663,4 +1264,48 @@ void TC_doVBlankProcess()
     // just inform the upload has been done (DMA queue) so we can released tilesets
     if (!uploadDone && uploadIndex)
         uploadDone = TRUE;
+
+    // RLE tilesets which didn't fit in unpack buffer --> unpack them directly in VRAM
+    if (numVRamUnpack)
+    {
+        u16 budget = MAX_VRAM_UNPACK_TILE;
+        u16 done = 0;
+        u16 i;
+
+        // limit number of unpacked tile per VBlank (at least one tileset so we always progress)
+        while(done < numVRamUnpack)
+        {
+            TileSet *tileset = vramUnpacks[done];
+            const u16 numTile = tileset->numTile;
+
+            if (done && (numTile > budget)) break;
+
+            rle4b_unpackVRam((u8*) tileset->tiles, vramUnpackIndexes[done] * 32, 0, 0);
+
+            budget = (numTile > budget)?0:(budget - numTile);
+            done++;
+        }
+
+        // remaining tilesets will be unpacked on next VBlank(s)
+        numVRamUnpack -= done;
+        for(i = 0; i < numVRamUnpack; i++)
+        {
+            vramUnpacks[i] = vramUnpacks[i + done];
+            vramUnpackIndexes[i] = vramUnpackIndexes[i + done];
+        }
+    }
+
+    // incremental defragmentation (uploads are done so we can safely move blocs, wait for pending VRAM unpacks as they use bloc index).
+    // A new pass can overwrite regions released by previous pass so wait for the cache user to send the new indexes to VDP
+    if (defragPending && defragCache && defragRefreshed && !numVRamUnpack)
+    {
+        // nothing more to move --> stop
+        if (!TC_defrag(defragCache, defragMaxTile))
+            defragPending = FALSE;
+        else
+        {
+            defragPass++;
+            defragRefreshed = FALSE;
+        }
+    }
 }
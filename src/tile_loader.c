@@ -0,0 +1,164 @@
+#include "config.h"
+#include "types.h"
+
+#include "tile_loader.h"
+
+#include "vdp.h"
+#include "vdp_tile.h"
+#include "dma.h"
+#include "tools.h"
+#include "memory.h"
+#include "sys.h"
+#include "kdebug.h"
+
+
+// pending loads (processed in order)
+static TileLoader *loads[TL_MAX_LOAD];
+// number of pending load
+static vu16 numLoad;
+// number of tile sent per frame
+static u16 budget = TL_DEFAULT_BUDGET;
+
+// don't want to share it
+extern vu32 VIntProcess;
+
+// forward
+static void removeLoad(TileLoader *loader);
+
+
+u16 TL_load(TileLoader *loader, const TileSet *tileset, u16 index)
+{
+    if (numLoad >= TL_MAX_LOAD)
+    {
+        if (LIB_DEBUG) KDebug_Alert("TL_load failed: too many pending loads !");
+        return FALSE;
+    }
+
+    // compressed tileset --> unpack it first (DMA need raw data)
+    if (tileset->compression != COMPRESSION_NONE)
+    {
+        loader->unpacked = unpackTileSet(tileset, NULL);
+        if (loader->unpacked == NULL) return FALSE;
+
+        loader->tiles = loader->unpacked->tiles;
+    }
+    else
+    {
+        loader->unpacked = NULL;
+        loader->tiles = tileset->tiles;
+    }
+
+    loader->index = index;
+    loader->numTile = tileset->numTile;
+    loader->done = 0;
+    loader->queuePos = 0;
+
+    // nothing to load
+    if (loader->numTile == 0) return TRUE;
+
+    // VBlank process read the list
+    SYS_disableInts();
+    loads[numLoad++] = loader;
+    VIntProcess |= PROCESS_TILELOAD_TASK;
+    SYS_enableInts();
+
+    return TRUE;
+}
+
+u16 TL_isComplete(TileLoader *loader)
+{
+    if (loader->done < loader->numTile) return FALSE;
+
+    // last chunk still in DMA queue ? (auto flush disabled, queue size is reset by the flush)
+    if (!DMA_getAutoFlush() && loader->queuePos && (DMA_getQueueSize() >= loader->queuePos)) return FALSE;
+
+    // we can release unpacked data now
+    if (loader->unpacked)
+    {
+        MEM_free(loader->unpacked);
+        loader->unpacked = NULL;
+    }
+
+    return TRUE;
+}
+
+u16 TL_getProgress(TileLoader *loader)
+{
+    return loader->done;
+}
+
+void TL_cancel(TileLoader *loader)
+{
+    SYS_disableInts();
+    removeLoad(loader);
+    SYS_enableInts();
+
+    if (loader->unpacked)
+    {
+        MEM_free(loader->unpacked);
+        loader->unpacked = NULL;
+    }
+
+    // consider it as done
+    loader->numTile = loader->done;
+}
+
+
+u16 TL_getBudget()
+{
+    return budget;
+}
+
+void TL_setBudget(u16 numTile)
+{
+    budget = numTile;
+}
+
+
+// called at VBlank to queue next chunks, returns FALSE when there is no more pending load (we don't want to share it)
+u16 TL_doVBlankProcess()
+{
+    u16 remaining = budget;
+
+    while(numLoad && remaining)
+    {
+        TileLoader *loader = loads[0];
+        const u16 done = loader->done;
+        u16 num = loader->numTile - done;
+
+        if (num > remaining) num = remaining;
+
+        // DMA queue full --> retry on next frame
+        if (!DMA_queueDma(DMA_VRAM, (u32) (loader->tiles + (done * 8)), (loader->index + done) * 32, num * 16, 2))
+            return TRUE;
+
+        loader->done = done + num;
+        loader->queuePos = DMA_getQueueSize();
+        remaining -= num;
+
+        // this one is complete (transfer is done in this VBlank)
+        if (loader->done >= loader->numTile) removeLoad(loader);
+    }
+
+    return (numLoad != 0);
+}
+
+
+static void removeLoad(TileLoader *loader)
+{
+    u16 i;
+
+    for(i = 0; i < numLoad; i++)
+    {
+        if (loads[i] == loader)
+        {
+            numLoad--;
+            while(i < numLoad)
+            {
+                loads[i] = loads[i + 1];
+                i++;
+            }
+            return;
+        }
+    }
+}
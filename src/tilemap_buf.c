@@ -0,0 +1,326 @@
+#include "config.h"
+#include "types.h"
+
+#include "tilemap_buf.h"
+
+#include "vdp.h"
+#include "memory.h"
+#include "dma.h"
+#include "sys.h"
+#include "kdebug.h"
+
+
+// registered buffers
+static TileMapBuffer *buffers[TMB_MAX_BUFFER];
+// number of registered buffer
+static u16 numBuffer;
+
+// don't want to share it
+extern vu32 VIntProcess;
+
+// forward
+static void setDirty(TileMapBuffer *buffer);
+static u16 flushRow(const u16 *src, u16 *mask, u16 w, u16 addr);
+static void markRange(u16 *mask, u16 start, u16 end);
+
+
+u16 TMB_init(TileMapBuffer *buffer, u16 plan, u16 x, u16 y, u16 w, u16 h)
+{
+    const u16 maskWidth = (w + 15) >> 4;
+
+    if (numBuffer >= TMB_MAX_BUFFER)
+    {
+        if (LIB_DEBUG) KDebug_Alert("TMB_init failed: no more buffer slot !");
+        return FALSE;
+    }
+
+    // tilemap and dirty masks in a single allocation
+    buffer->tilemap = MEM_alloc(((w * h) + (maskWidth * h)) * 2);
+    if (buffer->tilemap == NULL) return FALSE;
+
+    buffer->mask = buffer->tilemap + (w * h);
+    buffer->plan = plan;
+    buffer->x = x;
+    buffer->y = y;
+    buffer->w = w;
+    buffer->h = h;
+    buffer->maskWidth = maskWidth;
+
+    // window plan width only depends from screen width
+    if (plan == WINDOW) buffer->planWidth = (VDP_getScreenWidth() == 320)?64:32;
+    else buffer->planWidth = VDP_getPlanWidth();
+
+    // clear tilemap and dirty masks
+    memsetU16(buffer->tilemap, 0, (w * h) + (maskWidth * h));
+    // we don't know plan content --> send the whole region
+    TMB_markDirty(buffer, 0, 0, w, h);
+
+    buffers[numBuffer++] = buffer;
+
+    return TRUE;
+}
+
+void TMB_release(TileMapBuffer *buffer)
+{
+    u16 i;
+
+    // unregister buffer
+    for(i = 0; i < numBuffer; i++)
+    {
+        if (buffers[i] == buffer)
+        {
+            numBuffer--;
+            while(i < numBuffer)
+            {
+                buffers[i] = buffers[i + 1];
+                i++;
+            }
+            break;
+        }
+    }
+
+    MEM_free(buffer->tilemap);
+    buffer->tilemap = NULL;
+    buffer->mask = NULL;
+    buffer->dirty = FALSE;
+}
+
+
+void TMB_setTile(TileMapBuffer *buffer, u16 tile, u16 x, u16 y)
+{
+    u16 *dst;
+
+    if ((x >= buffer->w) || (y >= buffer->h)) return;
+
+    dst = &buffer->tilemap[(y * buffer->w) + x];
+
+    if (*dst != tile)
+    {
+        *dst = tile;
+        buffer->mask[(y * buffer->maskWidth) + (x >> 4)] |= 1 << (x & 15);
+        setDirty(buffer);
+    }
+}
+
+void TMB_fillRect(TileMapBuffer *buffer, u16 tile, u16 x, u16 y, u16 w, u16 h)
+{
+    u16 *dst;
+    u16 *mask;
+    u16 changed;
+    u16 i, j;
+
+    // clip
+    if ((x >= buffer->w) || (y >= buffer->h)) return;
+    if ((x + w) > buffer->w) w = buffer->w - x;
+    if ((y + h) > buffer->h) h = buffer->h - y;
+
+    dst = &buffer->tilemap[(y * buffer->w) + x];
+    mask = &buffer->mask[y * buffer->maskWidth];
+    changed = FALSE;
+
+    j = h;
+    while(j--)
+    {
+        for(i = x; i < (x + w); i++)
+        {
+            if (*dst != tile)
+            {
+                *dst = tile;
+                mask[i >> 4] |= 1 << (i & 15);
+                changed = TRUE;
+            }
+            dst++;
+        }
+
+        dst += buffer->w - w;
+        mask += buffer->maskWidth;
+    }
+
+    if (changed) setDirty(buffer);
+}
+
+void TMB_setTileMapRect(TileMapBuffer *buffer, const u16 *data, u16 basetile, u16 x, u16 y, u16 w, u16 h, u16 wm)
+{
+    const u16 baseindex = basetile & TILE_INDEX_MASK;
+    const u16 baseflags = basetile & TILE_ATTR_MASK;
+    const u16 *src;
+    u16 *dst;
+    u16 *mask;
+    u16 changed;
+    u16 i, j;
+
+    // clip
+    if ((x >= buffer->w) || (y >= buffer->h)) return;
+    if ((x + w) > buffer->w) w = buffer->w - x;
+    if ((y + h) > buffer->h) h = buffer->h - y;
+
+    src = data;
+    dst = &buffer->tilemap[(y * buffer->w) + x];
+    mask = &buffer->mask[y * buffer->maskWidth];
+    changed = FALSE;
+
+    j = h;
+    while(j--)
+    {
+        for(i = x; i < (x + w); i++)
+        {
+            const u16 tile = baseflags | (*src++ + baseindex);
+
+            if (*dst != tile)
+            {
+                *dst = tile;
+                mask[i >> 4] |= 1 << (i & 15);
+                changed = TRUE;
+            }
+            dst++;
+        }
+
+        src += wm - w;
+        dst += buffer->w - w;
+        mask += buffer->maskWidth;
+    }
+
+    if (changed) setDirty(buffer);
+}
+
+
+void TMB_markDirty(TileMapBuffer *buffer, u16 x, u16 y, u16 w, u16 h)
+{
+    u16 *mask;
+    u16 i, j;
+
+    // clip
+    if ((x >= buffer->w) || (y >= buffer->h)) return;
+    if ((x + w) > buffer->w) w = buffer->w - x;
+    if ((y + h) > buffer->h) h = buffer->h - y;
+
+    mask = &buffer->mask[y * buffer->maskWidth];
+
+    j = h;
+    while(j--)
+    {
+        for(i = x; i < (x + w); i++)
+            mask[i >> 4] |= 1 << (i & 15);
+
+        mask += buffer->maskWidth;
+    }
+
+    setDirty(buffer);
+}
+
+void TMB_markRowDirty(TileMapBuffer *buffer, u16 y)
+{
+    TMB_markDirty(buffer, 0, y, buffer->w, 1);
+}
+
+
+// called at VBlank to queue dirty cells, returns FALSE when all cells have been queued (we don't want to share it)
+u16 TMB_doVBlankProcess()
+{
+    u16 i;
+
+    for(i = 0; i < numBuffer; i++)
+    {
+        TileMapBuffer *buffer = buffers[i];
+
+        if (buffer->dirty)
+        {
+            const u16 *src = buffer->tilemap;
+            u16 *mask = buffer->mask;
+            u16 addr = buffer->plan + ((buffer->x + (buffer->y * buffer->planWidth)) * 2);
+            u16 j;
+
+            buffer->dirty = FALSE;
+
+            j = buffer->h;
+            while(j--)
+            {
+                // DMA queue full --> remaining cells will be sent on next frame
+                if (!flushRow(src, mask, buffer->w, addr))
+                {
+                    buffer->dirty = TRUE;
+                    return TRUE;
+                }
+
+                src += buffer->w;
+                mask += buffer->maskWidth;
+                addr += buffer->planWidth * 2;
+            }
+        }
+    }
+
+    return FALSE;
+}
+
+
+static void setDirty(TileMapBuffer *buffer)
+{
+    buffer->dirty = TRUE;
+    VIntProcess |= PROCESS_TILEMAP_TASK;
+}
+
+static u16 flushRow(const u16 *src, u16 *mask, u16 w, u16 addr)
+{
+    const u16 maskWidth = (w + 15) >> 4;
+    s16 start;
+    u16 end;
+    u16 x;
+    u16 i;
+
+    start = -1;
+    end = 0;
+    x = 0;
+
+    for(i = 0; i < maskWidth; i++, x += 16)
+    {
+        u16 m = mask[i];
+        u16 cx;
+
+        // clean cells
+        if (!m) continue;
+
+        mask[i] = 0;
+        cx = x;
+
+        while(m)
+        {
+            if (m & 1)
+            {
+                if (start == -1) start = cx;
+                // gap too large --> send current run and start a new one
+                else if ((cx - end) > TMB_RUN_GAP)
+                {
+                    if (!DMA_queueDma(DMA_VRAM, (u32) (src + start), addr + (start * 2), end - start, 2))
+                    {
+                        // restore dirty state of the remaining part of the row
+                        markRange(mask, start, w);
+                        return FALSE;
+                    }
+
+                    start = cx;
+                }
+
+                end = cx + 1;
+            }
+
+            m >>= 1;
+            cx++;
+        }
+    }
+
+    if ((start != -1) && !DMA_queueDma(DMA_VRAM, (u32) (src + start), addr + (start * 2), end - start, 2))
+    {
+        markRange(mask, start, end);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void markRange(u16 *mask, u16 start, u16 end)
+{
+    u16 i;
+
+    for(i = start; i < end; i++)
+        mask[i >> 4] |= 1 << (i & 15);
+}
@@ -18,6 +18,7 @@ static u16 getMapAllocSize(const Map *map);
 static Bitmap *allocateBitmapInternal(const Bitmap *bitmap, void *adr);
 static TileSet *allocateTileSetInternal(const TileSet *tileset, void *adr);
 static Map *allocateMapInternal(const Map *map, void *adr);
+static void unpackMapBlocks(const Map *src, u16 *dest);
 
 // internal
 static u32 framecnt;
@@ -874,7 +875,9 @@ Map *unpackMap(const Map *src, Map *dest)
         result->h = src->h;
 
         // unpack tilemap
-        if (src->compression != COMPRESSION_NONE)
+        if (src->compression == COMPRESSION_MAP_BLOCK)
+            unpackMapBlocks(src, result->tilemap);
+        else if (src->compression != COMPRESSION_NONE)
             unpack(src->compression, (u8*) src->tilemap, (u8*) result->tilemap);
         // simple copy if needed
         else if (src->tilemap != result->tilemap)
@@ -884,6 +887,19 @@ Map *unpackMap(const Map *src, Map *dest)
     return result;
 }
 
+u16 unpackMapBlock(const Map *src, u16 blockX, u16 blockY, u16 *dest)
+{
+    const u32 *index = (u32*) src->tilemap;
+    const u16 blockW = (src->w + (MAP_BLOCK_SIZE - 1)) / MAP_BLOCK_SIZE;
+
+    if (src->compression != COMPRESSION_MAP_BLOCK) return FALSE;
+
+    // block offset index is stored at beginning of data
+    rlemap_unpack(((u8*) src->tilemap) + index[(blockY * blockW) + blockX], (u8*) dest, 0, 0);
+
+    return TRUE;
+}
+
 Image *unpackImage(const Image *src, Image *dest)
 {
     Image *result;
@@ -908,6 +924,40 @@ Image *unpackImage(const Image *src, Image *dest)
 }
 
 
+static void unpackMapBlocks(const Map *src, u16 *dest)
+{
+    u16 block[MAP_BLOCK_SIZE * MAP_BLOCK_SIZE];
+    const u16 mapW = src->w;
+    const u16 mapH = src->h;
+    u16 bx, by;
+
+    for(by = 0; by < mapH; by += MAP_BLOCK_SIZE)
+    {
+        // last block row can be partial
+        const u16 h = ((mapH - by) < MAP_BLOCK_SIZE)?(mapH - by):MAP_BLOCK_SIZE;
+
+        for(bx = 0; bx < mapW; bx += MAP_BLOCK_SIZE)
+        {
+            // last block column can be partial
+            const u16 w = ((mapW - bx) < MAP_BLOCK_SIZE)?(mapW - bx):MAP_BLOCK_SIZE;
+            const u16 *s = block;
+            u16 *d = dest + (by * mapW) + bx;
+            u16 j;
+
+            unpackMapBlock(src, bx / MAP_BLOCK_SIZE, by / MAP_BLOCK_SIZE, block);
+
+            j = h;
+            while(j--)
+            {
+                memcpy(d, s, w * 2);
+                s += MAP_BLOCK_SIZE;
+                d += mapW;
+            }
+        }
+    }
+}
+
+
 u16 unpackEx(u16 compression, u8 *src, u8 *dest, u32 offset, u16 size)
 {
     switch(compression)
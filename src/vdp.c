@@ -24,6 +24,13 @@
 #define BPLAN_DEFAULT           0xC000
 
 static u8 regValues[0x13];
+// queued register values (written on next VBlank)
+static u8 queuedValues[0x13];
+// queued register mask (bit n = register n)
+static u32 queuedRegs;
+// number of control port write saved (current frame and last frame)
+static u16 regWriteSaved;
+static u16 regWriteSavedLast;
 
 const VDPPlan PLAN_B = { 0 };
 const VDPPlan PLAN_A = { 1 };
@@ -41,6 +48,10 @@ u16 screenHeight;
 extern u16 *text_plan;
 extern u16 text_basetile;
 
+// forward
+static void writeReg(u16 reg, u8 value);
+static u16 placeTable(u32 *starts, u32 *ends, u16 *num, u32 size, u32 align);
+
 
 void VDP_init()
 {
@@ -81,6 +92,10 @@ void VDP_init()
     regValues[0x11] = 0x00;                     /* reg 17 - window hpos */
     regValues[0x12] = 0x00;                     /* reg 18 - window vpos */
 
+    queuedRegs = 0;
+    regWriteSaved = 0;
+    regWriteSavedLast = 0;
+
     // set registers
     pw = (u16 *) GFX_CTRL_PORT;
     for (i = 0x00; i < 0x13; i++) *pw = 0x8000 | (i << 8) | regValues[i];
@@ -137,7 +152,6 @@ u8 VDP_getReg(u16 reg)
 
 void VDP_setReg(u16 reg, u8 value)
 {
-    vu16 *pw;
     u16 v;
 
     // update cached values
@@ -198,10 +212,27 @@ void VDP_setReg(u16 reg, u8 value)
             break;
     }
 
-    if (reg < 0x13) regValues[reg] = v;
+    if (reg < 0x13) writeReg(reg, v);
+    // not cached (DMA registers)
+    else *((vu16*) GFX_CTRL_PORT) = 0x8000 | (reg << 8) | v;
+}
 
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8000 | (reg << 8) | v;
+void VDP_queueReg(u16 reg, u8 value)
+{
+    const u32 mask = 1 << reg;
+
+    if (reg >= 0x13) return;
+
+    // already queued --> the previous value won't be written
+    if (queuedRegs & mask) regWriteSaved++;
+
+    queuedValues[reg] = value;
+    queuedRegs |= mask;
+}
+
+u16 VDP_getRegWriteSaved()
+{
+    return regWriteSavedLast;
 }
 
 u8 VDP_getEnable()
@@ -211,13 +242,8 @@ u8 VDP_getEnable()
 
 void VDP_setEnable(u8 value)
 {
-    vu16 *pw;
-
-    if (value) regValues[0x01] |= 0x40;
-    else regValues[0x01] &= ~0x40;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8100 | regValues[0x01];
+    if (value) writeReg(0x01, regValues[0x01] | 0x40);
+    else writeReg(0x01, regValues[0x01] & ~0x40);
 }
 
 
@@ -234,26 +260,16 @@ u16 VDP_getScreenHeight()
 
 void VDP_setScreenHeight224()
 {
-    vu16 *pw;
-
-    regValues[0x01] &= ~0x08;
+    writeReg(0x01, regValues[0x01] & ~0x08);
     screenHeight = 224;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8100 | regValues[0x01];
 }
 
 void VDP_setScreenHeight240()
 {
-    vu16 *pw;
-
     if (IS_PALSYSTEM)
     {
-        regValues[0x01] |= 0x08;
+        writeReg(0x01, regValues[0x01] | 0x08);
         screenHeight = 240;
-
-        pw = (u16 *) GFX_CTRL_PORT;
-        *pw = 0x8100 | regValues[0x01];
     }
 }
 
@@ -264,24 +280,14 @@ u16 VDP_getScreenWidth()
 
 void VDP_setScreenWidth256()
 {
-    vu16 *pw;
-
-    regValues[0x0C] &= ~0x81;
+    writeReg(0x0C, regValues[0x0C] & ~0x81);
     screenWidth = 256;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8C00 | regValues[0x0C];
 }
 
 void VDP_setScreenWidth320()
 {
-    vu16 *pw;
-
-    regValues[0x0C] |= 0x81;
+    writeReg(0x0C, regValues[0x0C] | 0x81);
     screenWidth = 320;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8C00 | regValues[0x0C];
 }
 
 
@@ -297,12 +303,7 @@ u16 VDP_getPlanHeight()
 
 void VDP_setPlanSize(u16 w, u16 h)
 {
-    vu16 *pw;
-
-    regValues[0x10] = (((h >> 5) - 1) << 4) | (((w >> 5) - 1) << 0);
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x9000 | regValues[0x10];
+    writeReg(0x10, (((h >> 5) - 1) << 4) | (((w >> 5) - 1) << 0));
 }
 
 
@@ -318,12 +319,7 @@ u8 VDP_getHorizontalScrollingMode()
 
 void VDP_setScrollingMode(u16 hscroll, u16 vscroll)
 {
-    vu16 *pw;
-
-    regValues[0x0B] = ((vscroll & 1) << 2) | (hscroll & 3);
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8B00 | regValues[0x0B];
+    writeReg(0x0B, ((vscroll & 1) << 2) | (hscroll & 3));
 }
 
 
@@ -334,12 +330,7 @@ u8 VDP_getBackgroundColor()
 
 void VDP_setBackgroundColor(u8 value)
 {
-    vu16 *pw;
-
-    regValues[0x07] = value & 0x3F;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8700 | regValues[0x07];
+    writeReg(0x07, value & 0x3F);
 }
 
 
@@ -350,35 +341,25 @@ u8 VDP_getAutoInc()
 
 void VDP_setAutoInc(u8 value)
 {
-    vu16 *pw;
-
-    regValues[0x0F] = value;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8F00 | value;
+    writeReg(0x0F, value);
 }
 
 
 void VDP_setHInterrupt(u8 value)
 {
-    vu16 *pw;
-
-    if (value) regValues[0x00] |= 0x10;
-    else regValues[0x00] &= ~0x10;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8000 | regValues[0x00];
+    if (value) writeReg(0x00, regValues[0x00] | 0x10);
+    else writeReg(0x00, regValues[0x00] & ~0x10);
 }
 
 void VDP_setHilightShadow(u8 value)
 {
-    vu16 *pw;
-
-    if (value) regValues[0x0C] |= 0x08;
-    else regValues[0x0C] &= ~0x08;
+    if (value) writeReg(0x0C, regValues[0x0C] | 0x08);
+    else writeReg(0x0C, regValues[0x0C] & ~0x08);
+}
 
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8C00 | regValues[0x0C];
+u8 VDP_getHilightShadow()
+{
+    return (regValues[0x0C] & 0x08)?TRUE:FALSE;
 }
 
 
@@ -389,12 +370,7 @@ u8 VDP_getHIntCounter()
 
 void VDP_setHIntCounter(u8 value)
 {
-    vu16 *pw;
-
-    regValues[0x0A] = value;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8A00 | regValues[0x0A];
+    writeReg(0x0A, value);
 }
 
 
@@ -431,19 +407,12 @@ u16 VDP_getHScrollTableAddress()
 
 void VDP_setAPlanAddress(u16 value)
 {
-    vu16 *pw;
-
     aplan_adr = value & 0xE000;
-    regValues[0x02] = aplan_adr / 0x400;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8200 | regValues[0x02];
+    writeReg(0x02, aplan_adr / 0x400);
 }
 
 void VDP_setWindowAddress(u16 value)
 {
-    vu16 *pw;
-
     if (regValues[0x0C] & 0x81)
         // 40H mode
         window_adr = value & 0xF000;
@@ -451,10 +420,7 @@ void VDP_setWindowAddress(u16 value)
         // 32H mode
         window_adr = value & 0xF800;
 
-    regValues[0x03] = window_adr / 0x400;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8300 | regValues[0x03];
+    writeReg(0x03, window_adr / 0x400);
 }
 
 void VDP_setWindowPlanAddress(u16 value)
@@ -464,19 +430,12 @@ void VDP_setWindowPlanAddress(u16 value)
 
 void VDP_setBPlanAddress(u16 value)
 {
-    vu16 *pw;
-
-    window_adr = value & 0xE000;
-    regValues[0x04] = window_adr / 0x2000;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8400 | regValues[0x04];
+    bplan_adr = value & 0xE000;
+    writeReg(0x04, bplan_adr / 0x2000);
 }
 
 void VDP_setSpriteListAddress(u16 value)
 {
-    vu16 *pw;
-
     if (regValues[0x0C] & 0x81)
         // 40H mode
         slist_adr = value & 0xFC00;
@@ -484,39 +443,145 @@ void VDP_setSpriteListAddress(u16 value)
         // 32H mode
         slist_adr = value & 0xFE00;
 
-    regValues[0x05] = slist_adr / 0x200;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8500 | regValues[0x05];
+    writeReg(0x05, slist_adr / 0x200);
 }
 
 void VDP_setHScrollTableAddress(u16 value)
 {
-    vu16 *pw;
-
     hscrl_adr = value & 0xFC00;
-    regValues[0x0D] = value / 0x400;
+    writeReg(0x0D, value / 0x400);
+}
 
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8D00 | regValues[0x0D];
+
+u16 VDP_computeLayout(const VDPLayoutConfig *config, VDPLayout *layout)
+{
+    const u16 h40 = (screenWidth == 320);
+    const u16 w = config->planWidth;
+    const u16 h = config->planHeight;
+    u32 starts[5];
+    u32 ends[5];
+    u32 tileSpace;
+    u32 prevEnd;
+    u32 holeSize;
+    u16 num;
+    u16 i, j;
+
+    // check plan size
+    if (((w != 32) && (w != 64) && (w != 128)) || ((h != 32) && (h != 64) && (h != 128)) || ((w * h) > 4096))
+        return FALSE;
+
+    layout->planWidth = w;
+    layout->planHeight = h;
+
+    // place tables from the end of VRAM (largest alignment first) so smaller tables fill the holes
+    num = 0;
+    layout->aplan = placeTable(starts, ends, &num, w * h * 2, 0x2000);
+    layout->bplan = placeTable(starts, ends, &num, w * h * 2, 0x2000);
+    layout->slist = placeTable(starts, ends, &num, h40?(80 * 8):(64 * 8), h40?0x400:0x200);
+    layout->hscrl = placeTable(starts, ends, &num, (config->hscrollMode == HSCROLL_PLANE)?4:(screenHeight * 4), 0x400);
+
+    // tile space ends at first table
+    tileSpace = 0x10000;
+    for(i = 0; i < num; i++)
+        if (starts[i] < tileSpace) tileSpace = starts[i];
+
+    // window tilemap should be the first table (its address defines the end of tile space)
+    if (config->window)
+    {
+        const u32 size = (h40?64:32) * 2 * (screenHeight >> 3);
+
+        tileSpace = (tileSpace - size) & ~(h40?0xFFF:0x7FF);
+        starts[num] = tileSpace;
+        ends[num] = tileSpace + size;
+        num++;
+    }
+    // not used --> just point on first table
+    else
+        tileSpace &= ~(h40?0xFFF:0x7FF);
+
+    layout->window = tileSpace;
+    layout->numTile = (tileSpace / TILE_SIZE) - (TILE_SYSTEMLENGTH + FONT_LEN);
+
+    // sort tables on address
+    for(i = 1; i < num; i++)
+    {
+        for(j = i; (j > 0) && (starts[j] < starts[j - 1]); j--)
+        {
+            u32 tmp;
+
+            tmp = starts[j];
+            starts[j] = starts[j - 1];
+            starts[j - 1] = tmp;
+            tmp = ends[j];
+            ends[j] = ends[j - 1];
+            ends[j - 1] = tmp;
+        }
+    }
+
+    // find largest unused area between tables
+    layout->holeIndex = 0;
+    layout->holeSize = 0;
+    prevEnd = starts[0];
+    for(i = 0; i <= num; i++)
+    {
+        const u32 end = (i < num)?starts[i]:0x10000;
+
+        // tables are at least 512 bytes aligned, only the end need to be rounded to tile
+        prevEnd = (prevEnd + (TILE_SIZE - 1)) & ~(TILE_SIZE - 1);
+        holeSize = (end > prevEnd)?(end - prevEnd) / TILE_SIZE:0;
+
+        if (holeSize > layout->holeSize)
+        {
+            layout->holeIndex = prevEnd / TILE_SIZE;
+            layout->holeSize = holeSize;
+        }
+
+        if ((i < num) && (ends[i] > prevEnd)) prevEnd = ends[i];
+    }
+
+    return TRUE;
 }
 
-void VDP_setScanMode(u16 value)
+void VDP_setLayout(const VDPLayout *layout)
 {
-    vu16 *pw;
+    VDP_waitDMACompletion();
+
+    VDP_setPlanSize(layout->planWidth, layout->planHeight);
+    VDP_setAPlanAddress(layout->aplan);
+    VDP_setBPlanAddress(layout->bplan);
+    VDP_setWindowAddress(layout->window);
+    VDP_setSpriteListAddress(layout->slist);
+    VDP_setHScrollTableAddress(layout->hscrl);
+
+    // VRAM content is not moved --> clear plans
+    VDP_clearPlan(APLAN, TRUE);
+    VDP_waitDMACompletion();
+    VDP_clearPlan(BPLAN, TRUE);
+    VDP_waitDMACompletion();
+
+    // font tiles location depends from window address
+    VDP_loadFont(&font_lib, FALSE);
 
+    // reset sprites in the new sprite list
+    VDP_resetSprites();
+    VDP_updateSprites();
+
+    // send scroll values in the new scroll table
+    VDP_queueHorizontalScrollTable(PLAN_A);
+    VDP_queueHorizontalScrollTable(PLAN_B);
+}
+
+void VDP_setScanMode(u16 value)
+{
     if (value == 0)
         // non-interlaced
-        regValues[0x0C] &= ~0x06;
+        writeReg(0x0C, regValues[0x0C] & ~0x06);
     else if (value == 1)
         // interlace mode 1
-        regValues[0x0C] = (regValues[0x0C] & ~0x04) | 0x02;
+        writeReg(0x0C, (regValues[0x0C] & ~0x04) | 0x02);
     else
         // interlace mode 2
-        regValues[0x0C] |= 0x06;
-
-    pw = (u16 *) GFX_CTRL_PORT;
-    *pw = 0x8C00 | regValues[0x0C];
+        writeReg(0x0C, regValues[0x0C] | 0x06);
 }
 
 void VDP_waitDMACompletion()
@@ -573,3 +638,72 @@ void VDP_showFPS(u16 float_display)
     // display FPS
     VDP_drawText(str, 1, 1);
 }
+
+
+// called at VBlank to write queued registers (we don't want to share it)
+void VDP_doVBlankRegProcess()
+{
+    u32 regs = queuedRegs;
+
+    if (regs)
+    {
+        const u8 *src = queuedValues;
+        u16 reg = 0;
+
+        queuedRegs = 0;
+
+        while(regs)
+        {
+            if (regs & 1) VDP_setReg(reg, src[reg]);
+            regs >>= 1;
+            reg++;
+        }
+    }
+
+    // frame done, save counter
+    regWriteSavedLast = regWriteSaved;
+    regWriteSaved = 0;
+}
+
+
+static u16 placeTable(u32 *starts, u32 *ends, u16 *num, u32 size, u32 align)
+{
+    // start from the end of VRAM
+    s32 addr = (0x10000 - size) & ~(align - 1);
+
+    while(addr >= 0)
+    {
+        u16 i;
+
+        // check for overlap
+        for(i = 0; i < *num; i++)
+            if ((addr < ends[i]) && ((addr + size) > starts[i])) break;
+
+        if (i == *num)
+        {
+            starts[*num] = addr;
+            ends[*num] = addr + size;
+            (*num)++;
+
+            return addr;
+        }
+
+        addr -= align;
+    }
+
+    // can't happen (VRAM can contain all tables)
+    return 0;
+}
+
+static void writeReg(u16 reg, u8 value)
+{
+    // register already set to this value --> no need to write it again
+    if (regValues[reg] == value)
+    {
+        regWriteSaved++;
+        return;
+    }
+
+    regValues[reg] = value;
+    *((vu16*) GFX_CTRL_PORT) = 0x8000 | (reg << 8) | value;
+}
@@ -9,6 +9,8 @@
 #include "vdp_dma.h"
 #include "vdp_pal.h"
 #include "vdp_tile.h"
+#include "dma.h"
+#include "sys.h"
 
 #include "font.h"
 #include "memory.h"
@@ -20,6 +22,41 @@ u16 text_basetile;
 // current VRAM upload tile position
 u16 curTileInd;
 
+// scroll tables shadow (index is plan.v)
+static s16 hscrollTables[2][VDP_SCROLL_H_TABLE_SIZE];
+static s16 vscrollTables[2][VDP_SCROLL_V_TABLE_SIZE];
+// bit 0-1 = horizontal table to update, bit 2-3 = vertical table to update
+static u16 scrollTablesDirty = 0;
+
+// we don't want to share it
+extern vu32 VIntProcess;
+
+// forward
+static void setTable(s16 *table, u16 size, u16 ind, const s16 *values, u16 len);
+static void writeTable(u32 cmd, const s16 *values, u16 len);
+
+
+s16 *VDP_getHorizontalScrollTable(VDPPlan plan)
+{
+    return hscrollTables[plan.v];
+}
+
+s16 *VDP_getVerticalScrollTable(VDPPlan plan)
+{
+    return vscrollTables[plan.v];
+}
+
+void VDP_queueHorizontalScrollTable(VDPPlan plan)
+{
+    scrollTablesDirty |= 1 << plan.v;
+    VIntProcess |= PROCESS_SCROLL_TASK;
+}
+
+void VDP_queueVerticalScrollTable(VDPPlan plan)
+{
+    scrollTablesDirty |= 4 << plan.v;
+    VIntProcess |= PROCESS_SCROLL_TASK;
+}
 
 void VDP_setHorizontalScroll(VDPPlan plan, s16 value)
 {
@@ -27,6 +64,9 @@ void VDP_setHorizontalScroll(VDPPlan plan, s16 value)
     vu32 *pl;
     u16 addr;
 
+    // keep shadow table in sync
+    hscrollTables[plan.v][0] = value;
+
     /* Point to vdp port */
     pw = (u16 *) GFX_DATA_PORT;
     pl = (u32 *) GFX_CTRL_PORT;
@@ -42,60 +82,46 @@ void VDP_setHorizontalScrollTile(VDPPlan plan, u16 tile, s16* values, u16 len, u
 {
     u16 addr;
 
-    addr = HSCRL + ((tile & 0x1F) * (4 * 8));
-    if (plan.v == PLAN_B.v) addr += 2;
+    tile &= 0x1F;
 
-    VDP_setAutoInc(4 * 8);
+    // keep shadow table in sync
+    setTable(hscrollTables[plan.v], VDP_SCROLL_H_TABLE_SIZE, tile, values, len);
 
-    if (use_dma) VDP_doDMAEx(VDP_DMA_VRAM, (u32) values, addr, len, -1);
-    else
+    // whole table will be sent through the DMA queue at VBlank
+    if (use_dma)
     {
-        vu16 *pw;
-        vu32 *pl;
-        u16 *src;
-        u16 i;
-
-        /* Point to vdp port */
-        pw = (u16 *) GFX_DATA_PORT;
-        pl = (u32 *) GFX_CTRL_PORT;
-
-        *pl = GFX_WRITE_VRAM_ADDR(addr);
+        VDP_queueHorizontalScrollTable(plan);
+        return;
+    }
 
-        src = values;
+    addr = HSCRL + (tile * (4 * 8));
+    if (plan.v == PLAN_B.v) addr += 2;
 
-        i = len;
-        while(i--) *pw = *src++;
-    }
+    VDP_setAutoInc(4 * 8);
+    writeTable(GFX_WRITE_VRAM_ADDR(addr), values, len);
 }
 
 void VDP_setHorizontalScrollLine(VDPPlan plan, u16 line, s16* values, u16 len, u16 use_dma)
 {
     u16 addr;
 
-    addr = HSCRL + ((line & 0xFF) * 4);
-    if (plan.v == PLAN_B.v) addr += 2;
+    line &= 0xFF;
 
-    VDP_setAutoInc(4);
+    // keep shadow table in sync
+    setTable(hscrollTables[plan.v], VDP_SCROLL_H_TABLE_SIZE, line, values, len);
 
-    if (use_dma) VDP_doDMAEx(VDP_DMA_VRAM, (u32) values, addr, len, -1);
-    else
+    // whole table will be sent through the DMA queue at VBlank
+    if (use_dma)
     {
-        vu16 *pw;
-        vu32 *pl;
-        u16 *src;
-        u16 i;
-
-        /* Point to vdp port */
-        pw = (u16 *) GFX_DATA_PORT;
-        pl = (u32 *) GFX_CTRL_PORT;
-
-        *pl = GFX_WRITE_VRAM_ADDR(addr);
+        VDP_queueHorizontalScrollTable(plan);
+        return;
+    }
 
-        src = values;
+    addr = HSCRL + (line * 4);
+    if (plan.v == PLAN_B.v) addr += 2;
 
-        i = len;
-        while(i--) *pw = *src++;
-    }
+    VDP_setAutoInc(4);
+    writeTable(GFX_WRITE_VRAM_ADDR(addr), values, len);
 }
 
 void VDP_setVerticalScroll(VDPPlan plan, s16 value)
@@ -104,6 +130,9 @@ void VDP_setVerticalScroll(VDPPlan plan, s16 value)
     vu32 *pl;
     u16 addr;
 
+    // keep shadow table in sync
+    vscrollTables[plan.v][0] = value;
+
     /* Point to vdp port */
     pw = (u16 *) GFX_DATA_PORT;
     pl = (u32 *) GFX_CTRL_PORT;
@@ -119,30 +148,76 @@ void VDP_setVerticalScrollTile(VDPPlan plan, u16 tile, s16* values, u16 len, u16
 {
     u16 addr;
 
-    addr = (tile & 0x1F) * 4;
+    tile &= 0x1F;
+
+    // keep shadow table in sync
+    setTable(vscrollTables[plan.v], VDP_SCROLL_V_TABLE_SIZE, tile, values, len);
+
+    // whole table will be sent through the DMA queue at VBlank
+    if (use_dma)
+    {
+        VDP_queueVerticalScrollTable(plan);
+        return;
+    }
+
+    addr = tile * 4;
     if (plan.v == PLAN_B.v) addr += 2;
 
     VDP_setAutoInc(4);
+    writeTable(GFX_WRITE_VSRAM_ADDR(addr), values, len);
+}
 
-    if (use_dma) VDP_doDMAEx(VDP_DMA_VSRAM, (u32) values, addr, len, -1);
-    else
-    {
-        vu16 *pw;
-        vu32 *pl;
-        u16 *src;
-        u16 i;
 
-        /* Point to vdp port */
-        pw = (u16 *) GFX_DATA_PORT;
-        pl = (u32 *) GFX_CTRL_PORT;
+// called at VBlank by SYS (we don't want to share it), return TRUE if some tables are still to send
+u16 VDP_doVBlankScrollProcess()
+{
+    const u16 dirty = scrollTablesDirty;
+    u16 queued = 0;
+    u16 len, step;
+
+    if (dirty & 3)
+    {
+        // transfer size and step depend from current scrolling mode
+        switch(VDP_getHorizontalScrollingMode())
+        {
+            case HSCROLL_TILE:
+                len = screenHeight >> 3;
+                step = 4 * 8;
+                break;
+
+            case HSCROLL_LINE:
+                len = screenHeight;
+                step = 4;
+                break;
+
+            default:
+                len = 1;
+                step = 4;
+                break;
+        }
 
-        *pl = GFX_WRITE_VSRAM_ADDR(addr);
+        // plan B scroll values are stored right after plan A ones
+        if ((dirty & (1 << PLAN_A.v)) && DMA_queueDma(DMA_VRAM, (u32) hscrollTables[PLAN_A.v], HSCRL + 0, len, step))
+            queued |= 1 << PLAN_A.v;
+        if ((dirty & (1 << PLAN_B.v)) && DMA_queueDma(DMA_VRAM, (u32) hscrollTables[PLAN_B.v], HSCRL + 2, len, step))
+            queued |= 1 << PLAN_B.v;
+    }
 
-        src = values;
+    if (dirty & 0xC)
+    {
+        if (VDP_getVerticalScrollingMode() == VSCROLL_2TILE) len = VDP_SCROLL_V_TABLE_SIZE;
+        else len = 1;
 
-        i = len;
-        while(i--) *pw = *src++;
+        if ((dirty & (4 << PLAN_A.v)) && DMA_queueDma(DMA_VSRAM, (u32) vscrollTables[PLAN_A.v], 0, len, 4))
+            queued |= 4 << PLAN_A.v;
+        if ((dirty & (4 << PLAN_B.v)) && DMA_queueDma(DMA_VSRAM, (u32) vscrollTables[PLAN_B.v], 2, len, 4))
+            queued |= 4 << PLAN_B.v;
     }
+
+    // DMA queue full --> keep remaining tables for next VBlank
+    scrollTablesDirty = dirty & ~queued;
+
+    return (scrollTablesDirty != 0);
 }
 
 
@@ -343,3 +418,39 @@ u16 VDP_drawImageEx(u16 plan, const Image *image, u16 basetile, u16 x, u16 y, u1
 
     return TRUE;
 }
+
+
+static void setTable(s16 *table, u16 size, u16 ind, const s16 *values, u16 len)
+{
+    const s16 *src;
+    s16 *dst;
+    u16 i;
+
+    // clip to table size
+    if (ind >= size) return;
+    if ((ind + len) > size) i = size - ind;
+    else i = len;
+
+    src = values;
+    dst = table + ind;
+    while(i--) *dst++ = *src++;
+}
+
+static void writeTable(u32 cmd, const s16 *values, u16 len)
+{
+    vu16 *pw;
+    vu32 *pl;
+    const s16 *src;
+    u16 i;
+
+    /* Point to vdp port */
+    pw = (u16 *) GFX_DATA_PORT;
+    pl = (u32 *) GFX_CTRL_PORT;
+
+    *pl = cmd;
+
+    src = values;
+
+    i = len;
+    while(i--) *pw = *src++;
+}
@@ -5,9 +5,14 @@
 #include "vdp_pal.h"
 
 #include "sys.h"
+#include "dma.h"
+#include "memory.h"
+#include "kdebug.h"
 
 
-#define PALETTEFADE_FRACBITS    8
+#define PALETTEFADE_FRACBITS        8
+// size of precomputed fading frames buffer in word (64 colors on 16 frames)
+#define PALETTEFADE_FRAMESSIZE      (64 * 16)
 
 
 // we don't want to share them
@@ -176,7 +181,7 @@ const u16 palette_blue[16] =
 };
 
 
-// used for palette fading (need 902 bytes of memory)
+// used for palette fading (need 3084 bytes of memory)
 static s16 final_pal[64];
 static s16 fading_palR[64];
 static s16 fading_palG[64];
@@ -184,13 +189,25 @@ static s16 fading_palB[64];
 static s16 fading_stepR[64];
 static s16 fading_stepG[64];
 static s16 fading_stepB[64];
+static u16 fading_pal[64];
 static u16 fading_from;
 static u16 fading_to;
 static s16 fading_cnt;
+// precomputed fading frames (static so async fading never has to release them)
+static u16 fading_frames[PALETTEFADE_FRAMESSIZE];
+// next precomputed frame to send
+static u16 *fading_frame;
+// number of remaining precomputed frames
+static u16 fading_numframe;
 
 
 // forward
+static void stepFadePalette();
+static void packFadePalette(u16 *dest);
 static void setFadePalette(u16 waitVSync);
+static u16 blendColor(u16 src, u16 dst, u16 level, u16 numLevel);
+static u16 allocBlend(PaletteBlend *blend, u16 index, u16 length, u16 numLevel);
+static void computeBlend(PaletteBlend *blend, const u16 *src, const u16 *dst);
 
 
 u16 VDP_getPaletteColor(u16 index)
@@ -226,26 +243,40 @@ void VDP_setPaletteColor(u16 index, u16 value)
 }
 
 
-static void setFadePalette(u16 waitVSync)
+static void stepFadePalette()
 {
     s16 *palR;
     s16 *palG;
     s16 *palB;
-    vu16 *pw;
-    vu32 *pl;
-    u16 addr;
+    s16 *stepR;
+    s16 *stepG;
+    s16 *stepB;
     u16 i;
 
-    // lazy optimization
-    if (VDP_getAutoInc() != 2)
-        VDP_setAutoInc(2);
+    i = fading_from;
 
-    /* point to vdp port */
-    pw = (u16 *) GFX_DATA_PORT;
-    pl = (u32 *) GFX_CTRL_PORT;
+    palR = fading_palR + i;
+    palG = fading_palG + i;
+    palB = fading_palB + i;
+    stepR = fading_stepR + i;
+    stepG = fading_stepG + i;
+    stepB = fading_stepB + i;
 
-    addr = fading_from * 2;
-    *pl = GFX_WRITE_CRAM_ADDR(addr);
+    i = (fading_to - fading_from) + 1;
+    while(i--)
+    {
+        *palR++ += *stepR++;
+        *palG++ += *stepG++;
+        *palB++ += *stepB++;
+    }
+}
+
+static void packFadePalette(u16 *dest)
+{
+    s16 *palR;
+    s16 *palG;
+    s16 *palB;
+    u16 i;
 
     i = fading_from;
 
@@ -253,9 +284,6 @@ static void setFadePalette(u16 waitVSync)
     palG = fading_palG + i;
     palB = fading_palB + i;
 
-    // wait for VSync
-    if (waitVSync) VDP_waitVSync();
-
     i = (fading_to - fading_from) + 1;
     while(i--)
     {
@@ -265,52 +293,74 @@ static void setFadePalette(u16 waitVSync)
         col |= ((*palG++ >> PALETTEFADE_FRACBITS) << VDPPALETTE_GREENSFT) & VDPPALETTE_GREENMASK;
         col |= ((*palB++ >> PALETTEFADE_FRACBITS) << VDPPALETTE_BLUESFT) & VDPPALETTE_BLUEMASK;
 
-        *pw = col;
+        *dest++ = col;
     }
 }
 
-u16 VDP_doStepFading(u16 waitVSync)
+static void setFadePalette(u16 waitVSync)
 {
-    // one step less
-    if (--fading_cnt <= 0)
-    {
-        // last step --> just recopy the final palette
-        if (waitVSync) VDP_waitVSync();
-        VDP_setPaletteColors(fading_from, final_pal + fading_from, (fading_to - fading_from) + 1);
+    packFadePalette(fading_pal);
 
-        return 0;
-    }
+    // wait for VSync
+    if (waitVSync) VDP_waitVSync();
 
-    s16 *palR;
-    s16 *palG;
-    s16 *palB;
-    s16 *stepR;
-    s16 *stepG;
-    s16 *stepB;
-    u16 i;
+    VDP_setPaletteColors(fading_from, fading_pal, (fading_to - fading_from) + 1);
+}
 
-    i = fading_from;
+static const u16 *getNextFadePalette()
+{
+    const u16 *result;
 
-    palR = fading_palR + i;
-    palG = fading_palG + i;
-    palB = fading_palB + i;
-    stepR = fading_stepR + i;
-    stepG = fading_stepG + i;
-    stepB = fading_stepB + i;
+    // last step --> final palette
+    if (fading_cnt <= 0) return (u16*) (final_pal + fading_from);
 
-    i = (fading_to - fading_from) + 1;
-    while(i--)
+    // precomputed frame
+    if (fading_numframe)
     {
-        *palR++ += *stepR++;
-        *palG++ += *stepG++;
-        *palB++ += *stepB++;
+        fading_numframe--;
+        result = fading_frame;
+        fading_frame += (fading_to - fading_from) + 1;
+
+        return result;
     }
 
-    // set current fade palette
-    setFadePalette(waitVSync);
+    // out of precomputed frames --> compute it now
+    stepFadePalette();
+    packFadePalette(fading_pal);
 
-//    if (--fading_cnt <= 0) return 0;
-    return 1;
+    return fading_pal;
+}
+
+u16 VDP_doStepFading(u16 waitVSync)
+{
+    const u16 *pal;
+
+    // one step less
+    fading_cnt--;
+    pal = getNextFadePalette();
+
+    // wait for VSync
+    if (waitVSync) VDP_waitVSync();
+    VDP_setPaletteColors(fading_from, (u16*) pal, (fading_to - fading_from) + 1);
+
+    return (fading_cnt > 0)?1:0;
+}
+
+// called at VBlank to send next fading step, returns FALSE when fading is done (we don't want to share it)
+u16 VDP_doVBlankFadingProcess()
+{
+    const u16 len = (fading_to - fading_from) + 1;
+    const u16 *pal;
+
+    // one step less
+    fading_cnt--;
+    pal = getNextFadePalette();
+
+    // queue CRAM transfer (done in this VBlank), queue full --> send it now
+    if (!DMA_queueDma(DMA_CRAM, (u32) pal, fading_from * 2, len, 2))
+        VDP_setPaletteColors(fading_from, (u16*) pal, len);
+
+    return (fading_cnt > 0)?TRUE:FALSE;
 }
 
 u16 VDP_initFading(u16 fromcol, u16 tocol, const u16 *palsrc, const u16 *paldst, u16 numframe, u16 waitVSync)
@@ -324,18 +374,25 @@ u16 VDP_initFading(u16 fromcol, u16 tocol, const u16 *palsrc, const u16 *paldst,
     s16 *stepR;
     s16 *stepG;
     s16 *stepB;
+    u16 *frame;
+    u16 len;
     u16 i;
 
     // can't do a fade on 0 frame !
     if (numframe == 0) return 0;
 
+    // stop current fading
+    SYS_disableInts();
+    VIntProcess &= ~PROCESS_PALETTE_FADING;
+    SYS_enableInts();
+
     fading_from = fromcol;
     fading_to = tocol;
     fading_cnt = numframe;
 
     src = palsrc;
     dst = paldst;
-    save = final_pal + fromcol;
+    save = (u16*) (final_pal + fromcol);
     palR = fading_palR + fromcol;
     palG = fading_palG + fromcol;
     palB = fading_palB + fromcol;
@@ -368,13 +425,31 @@ u16 VDP_initFading(u16 fromcol, u16 tocol, const u16 *palsrc, const u16 *paldst,
     // set current fade palette
     setFadePalette(waitVSync);
 
+    // precompute intermediate frames so fading steps only have to send them,
+    // frames which don't fit in buffer will be computed on the fly
+    len = (tocol - fromcol) + 1;
+    fading_numframe = PALETTEFADE_FRAMESSIZE / len;
+    if (fading_numframe > (numframe - 1)) fading_numframe = numframe - 1;
+    fading_frame = fading_frames;
+    frame = fading_frames;
+
+    i = fading_numframe;
+    while(i--)
+    {
+        stepFadePalette();
+        packFadePalette(frame);
+        frame += len;
+    }
+
     return 1;
 }
 
 
 void VDP_interruptFade()
 {
+    SYS_disableInts();
     VIntProcess &= ~PROCESS_PALETTE_FADING;
+    SYS_enableInts();
 }
 
 void VDP_fade(u16 fromcol, u16 tocol, const u16 *palsrc, const u16 *paldst, u16 numframe, u8 async)
@@ -458,6 +533,79 @@ void VDP_fadeInAll(const u16 *pal, u16 numframe, u8 async)
 }
 
 
+u16 VDP_initBlend(PaletteBlend *blend, u16 index, const u16 *src, const u16 *dst, u16 length, u16 numLevel)
+{
+    if (!allocBlend(blend, index, length, numLevel)) return FALSE;
+
+    computeBlend(blend, src, dst);
+
+    return TRUE;
+}
+
+u16 VDP_initBlendToColor(PaletteBlend *blend, u16 index, const u16 *src, u16 color, u16 strength, u16 length, u16 numLevel)
+{
+    u16 dst[64];
+    u16 i;
+
+    if (!allocBlend(blend, index, length, numLevel)) return FALSE;
+
+    // destination = source tinted with the specified strength
+    for(i = 0; i < length; i++) dst[i] = blendColor(src[i], color, strength, 256);
+
+    computeBlend(blend, src, dst);
+
+    return TRUE;
+}
+
+u16 VDP_initBlendToShadow(PaletteBlend *blend, u16 index, const u16 *src, u16 highlight, u16 length, u16 numLevel)
+{
+    u16 dst[64];
+    u16 i;
+
+    if (!allocBlend(blend, index, length, numLevel)) return FALSE;
+
+    // normal color component C is displayed at intensity 2C (on 0-14 scale), shadow at C and highlight at C + 7
+    for(i = 0; i < length; i++)
+    {
+        const u16 col = src[i];
+
+        // (C + 7) / 2 = (C / 2) + 3 + (C & 1) for each component (no carry between components)
+        if (highlight) dst[i] = ((col >> 1) & VDPPALETTE_COLORMASK) + 0x0666 + (col & 0x0222);
+        // C / 2 for each component
+        else dst[i] = (col >> 1) & VDPPALETTE_COLORMASK;
+    }
+
+    computeBlend(blend, src, dst);
+
+    return TRUE;
+}
+
+void VDP_releaseBlend(PaletteBlend *blend)
+{
+    if (blend->data)
+    {
+        MEM_free(blend->data);
+        blend->data = NULL;
+    }
+}
+
+const u16* VDP_getBlendPalette(const PaletteBlend *blend, u16 level)
+{
+    if (level > blend->numLevel) level = blend->numLevel;
+
+    return blend->data + (level * blend->length);
+}
+
+void VDP_setBlendLevel(const PaletteBlend *blend, u16 level)
+{
+    const u16 *pal = VDP_getBlendPalette(blend, level);
+
+    // queue is full --> set it now
+    if (!DMA_queueDma(DMA_CRAM, (u32) pal, blend->index * 2, blend->length, 2))
+        VDP_setPaletteColors(blend->index, (u16*) pal, blend->length);
+}
+
+
 u16 VDP_isDoingFade()
 {
     return (VIntProcess & PROCESS_PALETTE_FADING)?TRUE:FALSE;
@@ -467,3 +615,56 @@ void VDP_waitFadeCompletion()
 {
     while (VIntProcess & PROCESS_PALETTE_FADING);
 }
+
+
+static u16 blendColor(u16 src, u16 dst, u16 level, u16 numLevel)
+{
+    const u16 srcLevel = numLevel - level;
+    const u16 round = numLevel >> 1;
+    u16 r, g, b;
+
+    r = ((((src & VDPPALETTE_REDMASK) >> VDPPALETTE_REDSFT) * srcLevel) + (((dst & VDPPALETTE_REDMASK) >> VDPPALETTE_REDSFT) * level) + round) / numLevel;
+    g = ((((src & VDPPALETTE_GREENMASK) >> VDPPALETTE_GREENSFT) * srcLevel) + (((dst & VDPPALETTE_GREENMASK) >> VDPPALETTE_GREENSFT) * level) + round) / numLevel;
+    b = ((((src & VDPPALETTE_BLUEMASK) >> VDPPALETTE_BLUESFT) * srcLevel) + (((dst & VDPPALETTE_BLUEMASK) >> VDPPALETTE_BLUESFT) * level) + round) / numLevel;
+
+    return (r << VDPPALETTE_REDSFT) | (g << VDPPALETTE_GREENSFT) | (b << VDPPALETTE_BLUESFT);
+}
+
+static u16 allocBlend(PaletteBlend *blend, u16 index, u16 length, u16 numLevel)
+{
+    // blend can't exceed CRAM (and temporary blend buffers)
+    if ((index + length) > 64)
+    {
+        if (LIB_DEBUG) KDebug_Alert("VDP_initBlend(..) failed: index + length exceed 64 colors !");
+        return FALSE;
+    }
+
+    blend->index = index;
+    blend->length = length;
+    blend->numLevel = numLevel?numLevel:1;
+    blend->data = MEM_alloc((blend->numLevel + 1) * length * 2);
+
+    return (blend->data != NULL);
+}
+
+static void computeBlend(PaletteBlend *blend, const u16 *src, const u16 *dst)
+{
+    const u16 index = blend->index;
+    const u16 length = blend->length;
+    const u16 numLevel = blend->numLevel;
+    // shadow / highlight operator colors should not be modified
+    const u16 hs = VDP_getHilightShadow();
+    u16 *pal;
+    u16 level;
+    u16 i;
+
+    pal = blend->data;
+    for(level = 0; level <= numLevel; level++)
+    {
+        for(i = 0; i < length; i++)
+        {
+            if (hs && ((index + i) >= 62)) *pal++ = src[i];
+            else *pal++ = blendColor(src[i], dst[i], level, numLevel);
+        }
+    }
+}
@@ -0,0 +1,254 @@
+#include "config.h"
+#include "types.h"
+
+#include "vram.h"
+
+#include "tile_cache.h"
+#include "kdebug.h"
+
+
+// managed VRAM area
+static u16 areaStart;
+static u16 areaLimit;
+// registered caches (sorted in VRAM order)
+static TileCache *caches[VRAM_MAX_CACHE];
+// number of registered cache
+static u16 vramNumCache;
+// this variable is specifically cleared in SYS reset method
+u16 vramInitialized = FALSE;
+
+// forward
+static s16 getCacheIndex(TileCache *cache);
+static s16 reserveRegion(TileCache *cache, u16 size);
+static u16 growCache(u16 ind, u16 size);
+
+
+void VRAM_init(u16 startIndex, u16 size)
+{
+    areaStart = startIndex;
+    areaLimit = startIndex + size;
+    vramNumCache = 0;
+    vramInitialized = TRUE;
+}
+
+void VRAM_end()
+{
+    vramNumCache = 0;
+    vramInitialized = FALSE;
+}
+
+u16 VRAM_isInitialized()
+{
+    return vramInitialized;
+}
+
+u16 VRAM_createCache(TileCache *cache, u16 size)
+{
+    const s16 index = reserveRegion(cache, size);
+
+    if (index == -1) return FALSE;
+
+    TC_createCache(cache, index, size);
+    return TRUE;
+}
+
+u16 VRAM_createCacheEx(TileCache *cache, u16 size, u16 numBloc)
+{
+    const s16 index = reserveRegion(cache, size);
+
+    if (index == -1) return FALSE;
+
+    TC_createCacheEx(cache, index, size, numBloc);
+    return TRUE;
+}
+
+void VRAM_releaseCache(TileCache *cache)
+{
+    s16 ind = getCacheIndex(cache);
+
+    // unregister cache
+    if (ind != -1)
+    {
+        vramNumCache--;
+        while(ind < vramNumCache)
+        {
+            caches[ind] = caches[ind + 1];
+            ind++;
+        }
+    }
+
+    TC_releaseCache(cache);
+}
+
+u16 VRAM_setCacheSize(TileCache *cache, u16 size)
+{
+    const s16 ind = getCacheIndex(cache);
+    const u16 curSize = cache->limit - cache->startIndex;
+
+    // not managed
+    if (ind == -1) return FALSE;
+
+    if (size < curSize)
+        return TC_setRegion(cache, cache->startIndex, size);
+    if (size > curSize)
+        return growCache(ind, size - curSize);
+
+    return TRUE;
+}
+
+u16 VRAM_getFreeTile()
+{
+    u16 result;
+    u16 i;
+
+    if (!vramInitialized) return 0;
+
+    result = areaLimit - areaStart;
+    for(i = 0; i < vramNumCache; i++)
+        result -= caches[i]->limit - caches[i]->startIndex;
+
+    return result;
+}
+
+void VRAM_getCacheInfo(TileCache *cache, VRAMCacheInfo *info)
+{
+    const u16 free = TC_getFreeTile(cache);
+    const u16 largest = TC_getLargestFreeRegion(cache);
+
+    info->size = cache->limit - cache->startIndex;
+    info->free = free;
+    info->largestFree = largest;
+
+    if (free) info->fragmentation = 100 - ((largest * 100) / free);
+    else info->fragmentation = 0;
+}
+
+
+// called by TC_alloc(..) when the cache ran out of space (we don't want to share it)
+u16 VRAM_growCache(TileCache *cache, u16 size)
+{
+    const s16 ind = getCacheIndex(cache);
+
+    // not a managed cache
+    if (ind == -1) return FALSE;
+
+    return growCache(ind, size);
+}
+
+
+static s16 getCacheIndex(TileCache *cache)
+{
+    u16 i;
+
+    if (!vramInitialized) return -1;
+
+    for(i = 0; i < vramNumCache; i++)
+        if (caches[i] == cache) return i;
+
+    return -1;
+}
+
+static s16 reserveRegion(TileCache *cache, u16 size)
+{
+    u16 prev;
+    u16 ind;
+    u16 i;
+
+    if (!vramInitialized)
+    {
+        if (LIB_DEBUG) KDebug_Alert("VRAM_createCache failed: VRAM manager not initialized !");
+        return -1;
+    }
+    if (vramNumCache >= VRAM_MAX_CACHE)
+    {
+        if (LIB_DEBUG) KDebug_Alert("VRAM_createCache failed: no more cache slot !");
+        return -1;
+    }
+
+    // search first unassigned region large enough
+    prev = areaStart;
+    ind = 0;
+    while(ind < vramNumCache)
+    {
+        if ((caches[ind]->startIndex - prev) >= size) break;
+
+        prev = caches[ind]->limit;
+        ind++;
+    }
+
+    // last region too small ?
+    if ((ind == vramNumCache) && ((areaLimit - prev) < size))
+    {
+        if (LIB_DEBUG) KDebug_Alert("VRAM_createCache failed: no enough unassigned VRAM !");
+        return -1;
+    }
+
+    // insert cache in list (caller initializes it right after)
+    i = vramNumCache++;
+    while(i > ind)
+    {
+        caches[i] = caches[i - 1];
+        i--;
+    }
+
+    caches[ind] = cache;
+
+    return prev;
+}
+
+static u16 growCache(u16 ind, u16 size)
+{
+    TileCache *cache = caches[ind];
+    TileCache *prevCache = (ind > 0)?caches[ind - 1]:NULL;
+    TileCache *nextCache = (ind < (vramNumCache - 1))?caches[ind + 1]:NULL;
+    const u16 start = cache->startIndex;
+    const u16 limit = cache->limit;
+    const u16 prevLimit = prevCache?prevCache->limit:areaStart;
+    const u16 nextStart = nextCache?nextCache->startIndex:areaLimit;
+
+    // enough unassigned space after the cache ?
+    if ((nextStart - limit) >= size)
+    {
+        TC_setRegion(cache, start, (limit + size) - start);
+        // new space is free, start searching from there
+        cache->current = limit;
+        return TRUE;
+    }
+    // enough unassigned space before the cache ?
+    if ((start - prevLimit) >= size)
+    {
+        TC_setRegion(cache, start - size, (limit + size) - start);
+        cache->current = start - size;
+        return TRUE;
+    }
+    // try to borrow head of next cache
+    if (nextCache)
+    {
+        const u16 needed = size - (nextStart - limit);
+
+        if (((nextCache->limit - nextStart) > needed) &&
+            TC_setRegion(nextCache, nextStart + needed, (nextCache->limit - nextStart) - needed))
+        {
+            TC_setRegion(cache, start, (limit + size) - start);
+            cache->current = limit;
+            return TRUE;
+        }
+    }
+    // try to borrow tail of previous cache
+    if (prevCache)
+    {
+        const u16 needed = size - (start - prevLimit);
+
+        if (((prevLimit - prevCache->startIndex) > needed) &&
+            TC_setRegion(prevCache, prevCache->startIndex, (prevLimit - prevCache->startIndex) - needed))
+        {
+            TC_setRegion(cache, start - size, (limit + size) - start);
+            cache->current = start - size;
+            return TRUE;
+        }
+    }
+
+    if (LIB_DEBUG) KDebug_Alert("VRAM manager: no enough free VRAM to grow cache !");
+
+    return FALSE;
+}
@@ -0,0 +1,28 @@
+#ifndef _ANIMTILES_H_
+#define _ANIMTILES_H_
+
+#include "../inc/tile_tools.h"
+
+
+typedef struct {
+    int numFrame;
+    int numTile;
+    // number of unique frame (tileset)
+    int numTileset;
+    tileset_** tilesets;
+    // tileset index and duration of each frame
+    int* frameTileset;
+    int* frameTimer;
+} animtiles_;
+
+
+extern Plugin animtiles;
+
+// build animated tiles from a 4bpp tiled image, frames are read from left to right then top to bottom
+animtiles_* getAnimTiles(unsigned int* tiles, int wt, int ht, int w, int h, char* times);
+void freeAnimTiles(animtiles_* animtiles);
+
+void outAnimTiles(animtiles_* animtiles, FILE* fs, FILE* fh, char* id, int global);
+
+
+#endif // _ANIMTILES_H_
@@ -0,0 +1,26 @@
+#ifndef _METAMAP_H_
+#define _METAMAP_H_
+
+#include "../inc/tile_tools.h"
+
+
+typedef struct {
+    int metaSize;
+    int numMeta;
+    int w;
+    int h;
+    unsigned short* metatiles;
+    unsigned short* blockmap;
+} metamap_;
+
+
+extern Plugin metamap;
+
+// build metatile dictionary and block map from a tilemap
+metamap_* getMetaMap(tilemap_* map, int metaSize);
+void freeMetaMap(metamap_* metamap);
+
+void outMetaMap(metamap_* metamap, FILE* fs, FILE* fh, char* id, int global);
+
+
+#endif // _METAMAP_H_
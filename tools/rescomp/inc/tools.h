@@ -11,6 +11,10 @@
 //#define PACK_LZKN       2
 #define PACK_RLE        3
 #define PACK_MAP_RLE    4
+#define PACK_MAP_BLOCK  5
+
+// block size (in tile) for PACK_MAP_BLOCK compression
+#define MAP_BLOCK_SIZE  16
 
 
 #define MIN(a,b) (((a)<(b))?(a):(b))
@@ -73,6 +77,7 @@ int getCompression(char *str);
 
 unsigned char *pack(unsigned char* data, int inOffset, int size, int *outSize, int *method);
 unsigned char *packEx(unsigned char* data, int inOffset, int size, int intSize, int swap, int *outSize, int *method);
+unsigned char *packMapBlock(unsigned short* data, int w, int h, int *outSize);
 
 int maccer(char* fin, char* fout);
 int tfmcom(char* fin, char* fout);
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../inc/rescomp.h"
+#include "../inc/plugin.h"
+#include "../inc/tools.h"
+#include "../inc/img_tools.h"
+#include "../inc/tile_tools.h"
+
+#include "../inc/animtiles.h"
+#include "../inc/tileset.h"
+
+
+// forward
+static int isSupported(char *type);
+static int execute(char *info, FILE *fs, FILE *fh);
+
+// ANIMTILES resource support
+Plugin animtiles = { isSupported, execute };
+
+
+static int isSupported(char *type)
+{
+    if (!strcasecmp(type, "ANIMTILES")) return 1;
+
+    return 0;
+}
+
+static int execute(char *info, FILE *fs, FILE *fh)
+{
+    char temp[MAX_PATH_LEN];
+    char id[50];
+    char fileIn[MAX_PATH_LEN];
+    char timeStr[256];
+    int w, h, bpp;
+    int wf, hf;
+    int wt, ht;
+    int size;
+    int nbElem;
+    unsigned char *data;
+    unsigned char maxIndex;
+    animtiles_ *result;
+
+    strcpy(timeStr, "0");
+
+    nbElem = sscanf(info, "%s %s \"%[^\"]\" %d %d %s", temp, id, temp, &wf, &hf, timeStr);
+
+    if (nbElem < 5)
+    {
+        printf("Wrong ANIMTILES definition\n");
+        printf("ANIMTILES name \"file\" width height [time]\n");
+        printf("  name\t\tAnimTiles variable name\n");
+        printf("  file\tthe image containing the animation frames (should be a 8bpp .bmp or .png)\n");
+        printf("  width\twidth of a single frame in tile\n");
+        printf("  height\theight of a single frame in tile\n");
+        printf("  time\tframe duration in frame (single value or comma separated list, default = 0 = static).\n\n");
+
+        return FALSE;
+    }
+
+    if ((wf <= 0) || (hf <= 0))
+    {
+        printf("Error: ANIMTILES frame size should be > 0 (%d x %d)\n", wf, hf);
+        return FALSE;
+    }
+
+    // adjust input file path
+    adjustPath(resDir, temp, fileIn);
+
+    // retrieve basic infos about the image
+    if (!Img_getInfos(fileIn, &w, &h, &bpp)) return FALSE;
+
+    // get size in tile
+    wt = (w + 7) / 8;
+    ht = (h + 7) / 8;
+
+    // inform about incorrect size
+    if (((wt % wf) != 0) || ((ht % hf) != 0))
+    {
+        printf("Warning: Image %s size is not a multiple of frame size (%d x %d)\n", fileIn, w, h);
+        printf("Partial frames are ignored\n");
+    }
+    if ((wt < wf) || (ht < hf))
+    {
+        printf("Error: Image %s is smaller than a single frame\n", fileIn);
+        return FALSE;
+    }
+
+    // get image data (always 8bpp)
+    data = Img_getData(fileIn, &size, 8, 8);
+    if (!data) return FALSE;
+
+    // find max color index
+    maxIndex = getMaxIndex(data, size);
+    // not allowed here
+    if (maxIndex >= 16)
+    {
+        printf("Error: Image %s use color index >= 16\n", fileIn);
+        printf("ANIMTILES resource require image with a maximum of 16 colors.\n");
+        return FALSE;
+    }
+
+    // convert to 4BPP
+    data = to4bppAndFree(data, size);
+    if (!data) return FALSE;
+
+    // convert to tile
+    data = bmpToTile(data, 0, wt, ht);
+    if (!data) return FALSE;
+
+    result = getAnimTiles((unsigned int*) data, wt, ht, wf, hf, timeStr);
+    if (!result) return FALSE;
+
+    printf("AnimTiles: %d frames of %d tiles, %d unique frames\n", result->numFrame, result->numTile, result->numTileset);
+
+    // EXPORT ANIMTILES
+    outAnimTiles(result, fs, fh, id, TRUE);
+
+    freeAnimTiles(result);
+    free(data);
+
+    return TRUE;
+}
+
+
+animtiles_* getAnimTiles(unsigned int* tiles, int wt, int ht, int w, int h, char* times)
+{
+    int f, i, j, k;
+    int fx, fy;
+    int tileSize;
+    int time;
+    char *t;
+    unsigned int *frame;
+    animtiles_ *result;
+
+    tileSize = w * h * 8;
+
+    result = malloc(sizeof(animtiles_));
+    result->numFrame = (wt / w) * (ht / h);
+    result->numTile = w * h;
+    result->numTileset = 0;
+    result->tilesets = malloc(result->numFrame * sizeof(tileset_*));
+    result->frameTileset = malloc(result->numFrame * sizeof(int));
+    result->frameTimer = malloc(result->numFrame * sizeof(int));
+
+    t = strtok(times, ",");
+    time = 0;
+
+    for(f = 0; f < result->numFrame; f++)
+    {
+        fx = (f % (wt / w)) * w;
+        fy = (f / (wt / w)) * h;
+
+        // frame tiles (row ordered)
+        frame = malloc(tileSize * 4);
+        k = 0;
+        for(j = 0; j < h; j++)
+            for(i = 0; i < w; i++)
+                memcpy(&frame[(k++) * 8], &tiles[(((fy + j) * wt) + (fx + i)) * 8], 32);
+
+        // search for an identical frame
+        for(i = 0; i < result->numTileset; i++)
+            if (!memcmp(result->tilesets[i]->tiles, frame, tileSize * 4)) break;
+
+        // new frame
+        if (i == result->numTileset)
+            result->tilesets[result->numTileset++] = createTileSet(frame, result->numTile);
+        else
+            free(frame);
+
+        result->frameTileset[f] = i;
+
+        // last time value is used for remaining frames
+        if (t)
+        {
+            time = atoi(t);
+            t = strtok(NULL, ",");
+        }
+
+        result->frameTimer[f] = time;
+    }
+
+    return result;
+}
+
+void freeAnimTiles(animtiles_* animtiles)
+{
+    int i;
+
+    for(i = 0; i < animtiles->numTileset; i++)
+        freeTileset(animtiles->tilesets[i]);
+
+    free(animtiles->tilesets);
+    free(animtiles->frameTileset);
+    free(animtiles->frameTimer);
+    free(animtiles);
+}
+
+void outAnimTiles(animtiles_* animtiles, FILE* fs, FILE* fh, char* id, int global)
+{
+    int i;
+    char temp[MAX_PATH_LEN];
+
+    // unique frame tilesets (never compressed so they can be sent by DMA)
+    for(i = 0; i < animtiles->numTileset; i++)
+    {
+        sprintf(temp, "%s_tileset%d", id, i);
+        outTileset(animtiles->tilesets[i], fs, fh, temp, FALSE);
+    }
+
+    // frames
+    strcpy(temp, id);
+    strcat(temp, "_frames");
+    // declare
+    decl(fs, fh, NULL, temp, 2, FALSE);
+    for(i = 0; i < animtiles->numFrame; i++)
+    {
+        // TileSet pointer
+        fprintf(fs, "    dc.l    %s_tileset%d\n", id, animtiles->frameTileset[i]);
+        // frame duration
+        fprintf(fs, "    dc.w    %d\n", animtiles->frameTimer[i]);
+    }
+    fprintf(fs, "\n");
+
+    // animtiles structure
+    decl(fs, fh, "AnimTiles", id, 2, global);
+    // number of frame and number of tile per frame
+    fprintf(fs, "    dc.w    %d, %d\n", animtiles->numFrame, animtiles->numTile);
+    // frames pointer
+    fprintf(fs, "    dc.l    %s\n", temp);
+    fprintf(fs, "\n");
+}
@@ -55,7 +55,7 @@ static int execute(char *info, FILE *fs, FILE *fh)
         printf("IMAGE name \"file\" [packed [mapbase]]\n");
         printf("  name\t\tImage variable name\n");
         printf("  file\tthe image to convert to Image structure (should be a 8bpp .bmp or .png)\n");
-        printf("  packed\tcompression: -1 = AUTO, 0 = NONE, 1 = APLIB, 3 = RLE (default = NONE).\n");
+        printf("  packed\tcompression: -1 = AUTO, 0 = NONE, 1 = APLIB, 3 = RLE, 5 = MAPBLOCK (default = NONE).\n");
         printf("  mapbase\tdefine the base tilemap value, useful to set the priority, default palette and base tile index.\n\n");
 
         return FALSE;
@@ -106,7 +106,15 @@ static int execute(char *info, FILE *fs, FILE *fh)
     // pack data
     if (packed != PACK_NONE)
     {
-        if (!packTileSet(result->tileset, &packed)) return FALSE;
+        // map block compression only applies to the tilemap, use best compression for tileset
+        if (packed == PACK_MAP_BLOCK)
+        {
+            int tsPacked = PACK_AUTO;
+
+            if (!packTileSet(result->tileset, &tsPacked)) return FALSE;
+        }
+        else if (!packTileSet(result->tileset, &packed)) return FALSE;
+
         if (!packMap(result->map, &packed)) return FALSE;
     }
 
@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../inc/rescomp.h"
+#include "../inc/plugin.h"
+#include "../inc/tools.h"
+#include "../inc/img_tools.h"
+#include "../inc/tile_tools.h"
+
+#include "../inc/metamap.h"
+#include "../inc/palette.h"
+#include "../inc/tileset.h"
+
+
+// forward
+static int isSupported(char *type);
+static int execute(char *info, FILE *fs, FILE *fh);
+
+// METAMAP resource support
+Plugin metamap = { isSupported, execute };
+
+
+static int isSupported(char *type)
+{
+    if (!strcasecmp(type, "METAMAP")) return 1;
+
+    return 0;
+}
+
+static int execute(char *info, FILE *fs, FILE *fh)
+{
+    char temp[MAX_PATH_LEN];
+    char id[50];
+    char fileIn[MAX_PATH_LEN];
+    char packedStr[256];
+    int w, h, bpp;
+    int wt, ht;
+    int size, psize;
+    int packed;
+    int metaSize;
+    int maxIndex, mapBase;
+    int nbElem;
+    unsigned char *data;
+    unsigned short *palette;
+    tileimg_ *image;
+    metamap_ *result;
+
+    packed = 0;
+    mapBase = 0;
+    strcpy(packedStr, "0");
+
+    nbElem = sscanf(info, "%s %s \"%[^\"]\" %d %s %d", temp, id, temp, &metaSize, packedStr, &mapBase);
+
+    if (nbElem < 4)
+    {
+        printf("Wrong METAMAP definition\n");
+        printf("METAMAP name \"file\" metasize [packed [mapbase]]\n");
+        printf("  name\t\tMetaMap variable name\n");
+        printf("  file\tthe image to convert to MetaMap structure (should be a 8bpp .bmp or .png)\n");
+        printf("  metasize\tmetatile size in tile: 2 = 16x16 pixels, 4 = 32x32 pixels.\n");
+        printf("  packed\ttileset compression: -1 = AUTO, 0 = NONE, 1 = APLIB, 3 = RLE (default = NONE).\n");
+        printf("  mapbase\tdefine the base tilemap value, useful to set the priority, default palette and base tile index.\n\n");
+
+        return FALSE;
+    }
+
+    if ((metaSize != 2) && (metaSize != 4))
+    {
+        printf("Error: METAMAP metatile size should be 2 or 4 (%d)\n", metaSize);
+        return FALSE;
+    }
+
+    // adjust input file path
+    adjustPath(resDir, temp, fileIn);
+    // get packed value
+    packed = getCompression(packedStr);
+
+    // retrieve basic infos about the image
+    if (!Img_getInfos(fileIn, &w, &h, &bpp)) return FALSE;
+
+    // get size in tile
+    wt = (w + 7) / 8;
+    ht = (h + 7) / 8;
+
+    // inform about incorrect size
+    if (((wt % metaSize) != 0) || ((ht % metaSize) != 0))
+    {
+        printf("Warning: Image %s size is not a multiple of metatile size (%d x %d)\n", fileIn, w, h);
+        printf("Border metatiles will be padded by repeating last tile row / column\n");
+    }
+
+    // get image data (always 8bpp)
+    data = Img_getData(fileIn, &size, 8, 8);
+    if (!data) return FALSE;
+
+    // find max color index
+    maxIndex = getMaxIndex(data, size);
+    // not allowed here
+    if (maxIndex >= 64)
+    {
+        printf("Error: Image %s use color index >= 64\n", fileIn);
+        printf("METAMAP resource require image with a maximum of 64 colors.\n");
+        return FALSE;
+    }
+
+    // convert to tiled image
+    image = getTiledImage(data, wt, ht, TRUE, mapBase);
+    if (!image) return FALSE;
+
+    // build metatiles
+    result = getMetaMap(image->map, metaSize);
+    if (!result) return FALSE;
+
+    printf("MetaMap: %d metatiles for %d blocks (tilemap size = %d, metamap size = %d)\n", result->numMeta, result->w * result->h,
+           wt * ht * 2, (result->numMeta * metaSize * metaSize * 2) + (result->w * result->h * 2));
+
+    // pack tileset (metatiles and block map stay unpacked for random access)
+    if (packed != PACK_NONE)
+    {
+        if (!packTileSet(image->tileset, &packed)) return FALSE;
+    }
+
+    // get palette
+    palette = Img_getPalette(fileIn, &psize);
+    if (!palette) return FALSE;
+
+    // optimize palette size
+    if (maxIndex < 16) psize = 16;
+    else if (maxIndex < 32) psize = 32;
+    else if (maxIndex < 48) psize = 48;
+    else psize = 64;
+
+    // EXPORT PALETTE
+    strcpy(temp, id);
+    strcat(temp, "_palette");
+    outPalette(palette, 0, psize, fs, fh, temp, FALSE);
+
+    // EXPORT TILESET
+    strcpy(temp, id);
+    strcat(temp, "_tileset");
+    outTileset(image->tileset, fs, fh, temp, FALSE);
+
+    // EXPORT METAMAP
+    outMetaMap(result, fs, fh, id, TRUE);
+
+    freeMetaMap(result);
+    freeTiledImage(image);
+
+    return TRUE;
+}
+
+
+metamap_* getMetaMap(tilemap_* map, int metaSize)
+{
+    int i, j, bx, by;
+    int index;
+    int metaLen;
+    unsigned short *meta;
+    unsigned short *b;
+    metamap_ *result;
+
+    metaLen = metaSize * metaSize;
+
+    result = malloc(sizeof(metamap_));
+    result->metaSize = metaSize;
+    result->numMeta = 0;
+    result->w = (map->w + (metaSize - 1)) / metaSize;
+    result->h = (map->h + (metaSize - 1)) / metaSize;
+    result->blockmap = malloc(result->w * result->h * 2);
+    // worst case: one metatile per block
+    result->metatiles = malloc(result->w * result->h * metaLen * 2);
+
+    b = result->blockmap;
+
+    for(by = 0; by < result->h; by++)
+    {
+        for(bx = 0; bx < result->w; bx++)
+        {
+            // build metatile at end of dictionary
+            meta = &result->metatiles[result->numMeta * metaLen];
+
+            for(j = 0; j < metaSize; j++)
+            {
+                // pad border metatiles by repeating last row / column
+                const int y = MIN((by * metaSize) + j, map->h - 1);
+
+                for(i = 0; i < metaSize; i++)
+                {
+                    const int x = MIN((bx * metaSize) + i, map->w - 1);
+
+                    meta[(j * metaSize) + i] = map->data[(y * map->w) + x];
+                }
+            }
+
+            // search in dictionary
+            for(index = 0; index < result->numMeta; index++)
+                if (!memcmp(&result->metatiles[index * metaLen], meta, metaLen * 2)) break;
+
+            // new metatile
+            if (index == result->numMeta)
+            {
+                if (result->numMeta >= 0x10000)
+                {
+                    printf("Error: MetaMap uses more than 65536 metatiles !\n");
+                    freeMetaMap(result);
+                    return NULL;
+                }
+
+                result->numMeta++;
+            }
+
+            *b++ = index;
+        }
+    }
+
+    return result;
+}
+
+void freeMetaMap(metamap_* metamap)
+{
+    free(metamap->metatiles);
+    free(metamap->blockmap);
+    free(metamap);
+}
+
+void outMetaMap(metamap_* metamap, FILE* fs, FILE* fh, char* id, int global)
+{
+    char temp[MAX_PATH_LEN];
+
+    // metatiles data
+    strcpy(temp, id);
+    strcat(temp, "_metatiles");
+    // declare
+    decl(fs, fh, NULL, temp, 2, FALSE);
+    // output data
+    outS((unsigned char*) metamap->metatiles, 0, metamap->numMeta * metamap->metaSize * metamap->metaSize * 2, fs, 2);
+    fprintf(fs, "\n");
+
+    // block map data
+    strcpy(temp, id);
+    strcat(temp, "_blockmap");
+    // declare
+    decl(fs, fh, NULL, temp, 2, FALSE);
+    // output data
+    outS((unsigned char*) metamap->blockmap, 0, metamap->w * metamap->h * 2, fs, 2);
+    fprintf(fs, "\n");
+
+    // metamap structure
+    decl(fs, fh, "MetaMap", id, 2, global);
+    // Palette pointer
+    fprintf(fs, "    dc.l    %s_palette\n", id);
+    // TileSet pointer
+    fprintf(fs, "    dc.l    %s_tileset\n", id);
+    // metatile size and number of metatile
+    fprintf(fs, "    dc.w    %d, %d\n", metamap->metaSize, metamap->numMeta);
+    // size
+    fprintf(fs, "    dc.w    %d, %d\n", metamap->w, metamap->h);
+    // metatiles and block map pointers
+    fprintf(fs, "    dc.l    %s_metatiles\n", id);
+    fprintf(fs, "    dc.l    %s_blockmap\n", id);
+    fprintf(fs, "\n");
+}
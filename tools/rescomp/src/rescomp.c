@@ -14,6 +14,8 @@
 #include "../inc/tileset.h"
 #include "../inc/map.h"
 #include "../inc/image.h"
+#include "../inc/metamap.h"
+#include "../inc/animtiles.h"
 #include "../inc/sprite.h"
 #include "../inc/xgmmusic.h"
 #include "../inc/tfmmusic.h"
@@ -43,6 +45,8 @@ Plugin *plugins[] =
     &tileset,
     &map,
     &image,
+    &metamap,
+    &animtiles,
     &sprite,
     &xgm,
     &tfm,
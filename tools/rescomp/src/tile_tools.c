@@ -181,7 +181,11 @@ int packMap(tilemap_* map, int *method)
     int size;
     unsigned short *data;
 
-    data = (unsigned short*) packEx((unsigned char*) map->data, 0, map->w * map->h * 2, 2, TRUE, &size, method);
+    // block compression is only used on explicit request
+    if (*method == PACK_MAP_BLOCK)
+        data = (unsigned short*) packMapBlock(map->data, map->w, map->h, &size);
+    else
+        data = (unsigned short*) packEx((unsigned char*) map->data, 0, map->w * map->h * 2, 2, TRUE, &size, method);
     if (!data) return FALSE;
 
     if (data != map->data)
@@ -523,6 +523,7 @@ int getCompression(char *str)
 //    if (!strcmp(upstr, "LZKN") || !strcmp(upstr, "2")) return PACK_LZKN;
     if (!strcmp(upstr, "RLE") || !strcmp(upstr, "3")) return PACK_RLE;
     if (!strcmp(upstr, "RLEMAP") || !strcmp(upstr, "4")) return PACK_MAP_RLE;
+    if (!strcmp(upstr, "MAPBLOCK") || !strcmp(upstr, "5")) return PACK_MAP_BLOCK;
 
     return 0;
 }
@@ -667,6 +668,80 @@ unsigned char *packEx(unsigned char* data, int inOffset, int size, int intSize,
     return result;
 }
 
+unsigned char *packMapBlock(unsigned short* data, int w, int h, int *outSize)
+{
+    unsigned char block[MAP_BLOCK_SIZE * MAP_BLOCK_SIZE * 2];
+    unsigned char* result;
+    unsigned char* packed;
+    int blockW, blockH, numBlock;
+    int bx, by, i, j;
+    int offset, size;
+
+    blockW = (w + (MAP_BLOCK_SIZE - 1)) / MAP_BLOCK_SIZE;
+    blockH = (h + (MAP_BLOCK_SIZE - 1)) / MAP_BLOCK_SIZE;
+    numBlock = blockW * blockH;
+
+    // worst case: 1 RLE bloc per entry (3 bytes) + bloc number + alignment for each block
+    result = (unsigned char *) malloc((numBlock * 4) + (numBlock * ((MAP_BLOCK_SIZE * MAP_BLOCK_SIZE * 3) + 4)));
+    if (result == NULL)
+    {
+        printf("packMapBlock failed: could not allocate memory !\n");
+        return NULL;
+    }
+
+    // block data start after the offset index
+    offset = numBlock * 4;
+
+    for(by = 0; by < blockH; by++)
+    {
+        for(bx = 0; bx < blockW; bx++)
+        {
+            const int ind = (by * blockW) + bx;
+
+            // get block data (big endian), border blocks are padded by repeating last row / column
+            for(j = 0; j < MAP_BLOCK_SIZE; j++)
+            {
+                const int y = MIN((by * MAP_BLOCK_SIZE) + j, h - 1);
+
+                for(i = 0; i < MAP_BLOCK_SIZE; i++)
+                {
+                    const int x = MIN((bx * MAP_BLOCK_SIZE) + i, w - 1);
+                    const unsigned short value = data[(y * w) + x];
+
+                    block[((j * MAP_BLOCK_SIZE) + i) * 2 + 0] = value >> 8;
+                    block[((j * MAP_BLOCK_SIZE) + i) * 2 + 1] = value >> 0;
+                }
+            }
+
+            packed = rlemappack(block, MAP_BLOCK_SIZE * MAP_BLOCK_SIZE * 2, &size);
+            if (packed == NULL)
+            {
+                free(result);
+                return NULL;
+            }
+
+            // store block offset (big endian)
+            result[(ind * 4) + 0] = offset >> 24;
+            result[(ind * 4) + 1] = offset >> 16;
+            result[(ind * 4) + 2] = offset >> 8;
+            result[(ind * 4) + 3] = offset >> 0;
+
+            memcpy(&result[offset], packed, size);
+            offset += size;
+            // keep block data word aligned
+            if (offset & 1) result[offset++] = 0;
+
+            free(packed);
+        }
+    }
+
+    printf("Packed with MAP BLOCK, original size = %d compressed to %d (%g %%)\n", w * h * 2, offset, (offset * 100.0) / (float) (w * h * 2));
+
+    *outSize = offset;
+
+    return result;
+}
+
 int maccer(char* fin, char* fout)
 {
     char cmd[MAX_PATH_LEN * 2];